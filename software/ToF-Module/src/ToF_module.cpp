@@ -6,6 +6,9 @@ ToF_module::ToF_module(OneWireMInterface & aInterface, uint8_t aId) :
     mStatus = TOF_STATUS_OK;
     mMainWired = false;
     mAuxWired = false;
+    mLastFrameSeq = 0;
+    mRecorder = nullptr;
+    mNewDataSources = 0xFF;
 }
 
 OneWireStatus ToF_module::init()
@@ -26,10 +29,18 @@ OneWireStatus ToF_module::init()
         return ret;
     }
     uint8_t wiringStatus = 0;
-    ret = read(TOF_WIRING_STATUS, wiringStatus);
+    uint32_t start = millis();
+    while ((ret = read(TOF_WIRING_STATUS, wiringStatus)) == OW_STATUS_OK &&
+            (wiringStatus & TOF_WIRING_BOOTING)) {
+        if (millis() - start >= TOF_BOOT_TIMEOUT) {
+            ret = OW_STATUS_TIMEOUT;
+            break;
+        }
+        delay(TOF_BOOT_POLL_DELAY);
+    }
     if (ret == OW_STATUS_OK) {
-        mMainWired = wiringStatus & 1;
-        mAuxWired = wiringStatus & 2;
+        mMainWired = wiringStatus & TOF_WIRING_MAIN;
+        mAuxWired = wiringStatus & TOF_WIRING_AUX;
     }
     return ret;
 }
@@ -86,8 +97,17 @@ uint8_t ToF_module::firmware()
 
 int ToF_module::communicationSpeed(uint32_t aBaudrate)
 {
-    uint8_t value = 2000000 / aBaudrate - 1;
-    if (value == 0) { // forbid 2MBd rate, because it is out of spec, and can be difficult to undo
+    if (aBaudrate == 0) {
+        return EXIT_FAILURE;
+    }
+    uint32_t divider = (2000000 + aBaudrate / 2) / aBaudrate;
+    if (divider < 2 || divider > TOF_BAUDRATE_MAX_VALUE + 1) {
+        return EXIT_FAILURE;
+    }
+    uint8_t value = divider - 1;
+    uint32_t real = moduleBaudrate(value);
+    uint32_t error = real > aBaudrate ? real - aBaudrate : aBaudrate - real;
+    if (!baudrateAccurate(value) || error * 1000 > aBaudrate * TOF_BAUDRATE_TOLERANCE) {
         return EXIT_FAILURE;
     }
     OneWireStatus ret = write(TOF_BAUDRATE, value);
@@ -99,6 +119,57 @@ int ToF_module::communicationSpeed(uint32_t aBaudrate)
     }
 }
 
+uint32_t ToF_module::realCommunicationSpeed()
+{
+    uint32_t baudrate = 0;
+    if (read(TOF_REAL_BAUDRATE, baudrate) != OW_STATUS_OK) {
+        return 0;
+    }
+    return baudrate;
+}
+
+uint32_t ToF_module::moduleBaudrate(uint8_t value)
+{
+    uint32_t requested = 2000000 / ((uint32_t)value + 1);
+    uint32_t ubrr = (TOF_MODULE_F_CPU / 4 / requested - 1) / 2;
+    return TOF_MODULE_F_CPU / 8 / (ubrr + 1);
+}
+
+bool ToF_module::baudrateAccurate(uint8_t value)
+{
+    uint32_t requested = 2000000 / ((uint32_t)value + 1);
+    uint32_t real = moduleBaudrate(value);
+    uint32_t error = real > requested ? real - requested : requested - real;
+    return error * 1000 <= requested * TOF_BAUDRATE_TOLERANCE;
+}
+
+uint32_t ToF_module::bestBaudrate(uint8_t moduleCount, uint16_t frequency,
+    uint8_t returnDelayTime)
+{
+    /* readRange(): 8 bytes instruction packet + 9 bytes status packet,
+     * 10 bits per byte */
+    const uint32_t bitsPerRead = 17 * 10;
+    uint32_t reads = (uint32_t)moduleCount * frequency;
+    if (reads == 0) {
+        return moduleBaudrate(TOF_BAUDRATE_MAX_VALUE);
+    }
+    /* us left to transmit each read, half of the bus time minus the return
+     * delay */
+    uint32_t budget = 500000 / reads;
+    uint32_t delay = (uint32_t)returnDelayTime * 2;
+    if (budget <= delay) {
+        return 0;
+    }
+    budget -= delay;
+    uint32_t required = (bitsPerRead * 1000000 + budget - 1) / budget;
+    for (uint16_t value = TOF_BAUDRATE_MAX_VALUE; value >= 1; value--) {
+        if (baudrateAccurate(value) && moduleBaudrate(value) >= required) {
+            return moduleBaudrate(value);
+        }
+    }
+    return 0;
+}
+
 int ToF_module::statusReturnLevel(uint8_t aSRL)
 {
     OneWireStatus ret = write(TOF_STATUS_RETURN_LEVEL, aSRL);
@@ -225,3 +296,551 @@ TofValue ToF_module::auxReadRange()
         return (TofValue)SENSOR_NOT_UPDATED;
     }
 }
+
+int ToF_module::setNewDataSources(uint8_t sources)
+{
+    OneWireStatus ret = write(TOF_NEW_DATA_SOURCES, sources);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        mNewDataSources = sources;
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+bool ToF_module::pollNewData()
+{
+    return ping() == OW_STATUS_OK && newData();
+}
+
+TofValue ToF_module::readRangeIfNew()
+{
+    if (mNewDataSources != TOF_NEW_DATA_MAIN) {
+        return readRange();
+    }
+    if (!mMainWired || ping() != OW_STATUS_OK) {
+        return (TofValue)SENSOR_NOT_UPDATED;
+    }
+    if (mStatus & TOF_STATUS_MAIN_SENSOR_ERROR) {
+        return (TofValue)SENSOR_DEAD;
+    }
+    if (!newData()) {
+        return (TofValue)SENSOR_NOT_UPDATED;
+    }
+    return readRange();
+}
+
+TofValue ToF_module::auxReadRangeIfNew()
+{
+    if (mNewDataSources != TOF_NEW_DATA_AUX) {
+        return auxReadRange();
+    }
+    if (!mAuxWired || ping() != OW_STATUS_OK) {
+        return (TofValue)SENSOR_NOT_UPDATED;
+    }
+    if (mStatus & TOF_STATUS_AUX_SENSOR_ERROR) {
+        return (TofValue)SENSOR_DEAD;
+    }
+    if (!newData()) {
+        return (TofValue)SENSOR_NOT_UPDATED;
+    }
+    return auxReadRange();
+}
+
+int ToF_module::setCollisionAlarm(uint16_t threshold)
+{
+    OneWireStatus ret = write(TOF_COLLISION_ALARM, threshold);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::readMotion(bool aux, int16_t &velocity, uint16_t &timeToContact)
+{
+    if (!(aux ? mAuxWired : mMainWired)) {
+        return EXIT_FAILURE;
+    }
+    if (read(aux ? TOF_AUX_RANGE_RATE : TOF_MAIN_RANGE_RATE, velocity) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    if (read(aux ? TOF_AUX_TIME_TO_CONTACT : TOF_MAIN_TIME_TO_CONTACT, timeToContact) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int ToF_module::setInterleaved(TofInterleavedMode mode, int16_t mainOffset,
+    int16_t auxOffset)
+{
+    uint8_t data[5];
+    data[0] = mode;
+    data[1] = (uint16_t)mainOffset & 0xFF;
+    data[2] = (uint16_t)mainOffset >> 8;
+    data[3] = (uint16_t)auxOffset & 0xFF;
+    data[4] = (uint16_t)auxOffset >> 8;
+    OneWireStatus ret = write(TOF_INTERLEAVED_MODE, data);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+TofValue ToF_module::mergedReadRange(uint16_t *timestamp)
+{
+    uint8_t result[5] = { 0, };
+    if (mMainWired && mAuxWired && read(TOF_MERGED_MCSLR, result) == OW_STATUS_OK) {
+        if (mStatus & (TOF_STATUS_MAIN_SENSOR_ERROR | TOF_STATUS_AUX_SENSOR_ERROR)) {
+            return (TofValue)SENSOR_DEAD;
+        }
+        else if (result[0] == 0) {
+            return (TofValue)SENSOR_NOT_UPDATED;
+        }
+        else {
+            if (timestamp) {
+                *timestamp = (uint16_t)result[3] + ((uint16_t)result[4] << 8);
+            }
+            uint16_t res = (uint16_t)result[1] + ((uint16_t)result[2] << 8);
+            return (TofValue)res;
+        }
+    }
+    else {
+        return (TofValue)SENSOR_NOT_UPDATED;
+    }
+}
+
+uint8_t ToF_module::readTrace(uint8_t data[TOF_TRACE_WINDOW_SIZE], uint8_t *pending)
+{
+    uint8_t result[TOF_TRACE_WINDOW_SIZE + 1] = { 0, };
+    if (read(TOF_TRACE_COUNT, result) != OW_STATUS_OK) {
+        return 0;
+    }
+    if (pending) {
+        *pending = result[0];
+    }
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < TOF_TRACE_WINDOW_SIZE; i++) {
+        data[i] = result[i + 1];
+        if (i % TOF_TRACE_RECORD_SIZE == 0 && data[i] != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int ToF_module::setStatistics(uint16_t window, uint16_t binWidth)
+{
+    uint8_t data[4];
+    data[0] = window & 0xFF;
+    data[1] = window >> 8;
+    data[2] = binWidth & 0xFF;
+    data[3] = binWidth >> 8;
+    OneWireStatus ret = write(TOF_STATS_WINDOW, data);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::resetStatistics(bool main, bool aux)
+{
+    uint8_t mask = (main ? 1 : 0) | (aux ? 2 : 0);
+    OneWireStatus ret = write(TOF_STATS_RESET, mask);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::setOutlierGate(uint16_t gate, uint8_t confirm)
+{
+    uint8_t data[3];
+    data[0] = gate & 0xFF;
+    data[1] = gate >> 8;
+    data[2] = confirm;
+    OneWireStatus ret = write(TOF_OUTLIER_GATE, data);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::readValidity(bool aux, TofValidity &validity, uint16_t &rejectCount)
+{
+    uint8_t result[6];
+    if (read(TOF_MAIN_VALIDITY, result) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    validity = (TofValidity)result[aux ? 1 : 0];
+    rejectCount = aux ? (result[4] | ((uint16_t)result[5] << 8)) :
+        (result[2] | ((uint16_t)result[3] << 8));
+    return EXIT_SUCCESS;
+}
+
+int ToF_module::setIdleSleep(bool enable)
+{
+    OneWireStatus ret = write(TOF_IDLE_SLEEP, (uint8_t)enable);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::readSleepStats(uint32_t &wakeups, uint32_t &sleepTime)
+{
+    uint32_t result[2];
+    if (read(TOF_WAKEUP_COUNT, result) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    wakeups = result[0];
+    sleepTime = result[1];
+    return EXIT_SUCCESS;
+}
+
+int ToF_module::setIndirect(const uint8_t *addresses, uint8_t count)
+{
+    if (count > TOF_INDIRECT_SIZE) {
+        return EXIT_FAILURE;
+    }
+    uint8_t table[TOF_INDIRECT_SIZE];
+    for (uint8_t i = 0; i < TOF_INDIRECT_SIZE; i++) {
+        table[i] = i < count ? addresses[i] : TOF_INDIRECT_UNUSED;
+    }
+    OneWireStatus ret = write(TOF_INDIRECT_ADDRESS, table);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::setTimingBudget(bool aux, uint8_t budget, TofDistanceMode mode)
+{
+    if (budget < TOF_TIMING_BUDGET_MIN) {
+        return EXIT_FAILURE;
+    }
+    uint32_t period;
+    if (read(aux ? TOF_AUX_PERIOD : TOF_MAIN_PERIOD, period) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    if (period != 0 && period < (uint32_t)budget + TOF_TIMING_BUDGET_OVERHEAD) {
+        return EXIT_FAILURE;
+    }
+    uint8_t data[2];
+    data[0] = budget;
+    data[1] = (uint8_t)mode;
+    OneWireStatus ret = write(aux ? TOF_AUX_TIMING_BUDGET : TOF_MAIN_TIMING_BUDGET, data);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+float ToF_module::measureRate(bool aux)
+{
+    uint16_t rate = 0;
+    if (read(aux ? TOF_AUX_MEASURE_RATE : TOF_MAIN_MEASURE_RATE, rate) != OW_STATUS_OK) {
+        return 0;
+    }
+    return rate / 1000.0;
+}
+
+int ToF_module::setExternalTrigger(bool enable, uint8_t delay)
+{
+    uint8_t data[2];
+    data[0] = enable;
+    data[1] = delay;
+    OneWireStatus ret = write(TOF_EXTERNAL_TRIGGER, data);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+OneWireStatus ToF_module::triggerAll(OneWireMInterface &interface, bool main, bool aux)
+{
+    uint8_t mask = (main ? 1 : 0) | (aux ? 2 : 0);
+    uint8_t status;
+    return interface.write(TOF_BROADCAST_ID, TOF_TRIGGER, mask, 0, &status);
+}
+
+uint8_t ToF_module::gather(ToF_module *modules[], uint8_t count,
+    TofFrame frames[], bool done[], uint32_t timeout)
+{
+    /* TOF_TRIGGER reads as 0 once the triggered measurements are published */
+    uint8_t doneCount = 0;
+    uint32_t start = millis();
+    for (uint8_t i = 0; i < count; i++) {
+        done[i] = false;
+    }
+    while (doneCount < count && millis() - start < timeout) {
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t pending = 0;
+            if (done[i] || modules[i]->read(TOF_TRIGGER, pending) != OW_STATUS_OK ||
+                    pending != 0) {
+                continue;
+            }
+            if (modules[i]->readFrame(frames[i]) == EXIT_SUCCESS) {
+                done[i] = true;
+                doneCount++;
+            }
+        }
+    }
+    return doneCount;
+}
+
+OneWireStatus ToF_module::syncAll(OneWireMInterface &interface, uint32_t baudrate)
+{
+    /* The module timestamps the message once fully received: 11 bytes of
+     * 10 bits, header, ID, length, instruction, address, time and checksum */
+    uint32_t transmission = 110UL * 1000000 / baudrate;
+    uint32_t time = micros() + transmission;
+    uint8_t status;
+    return interface.write(TOF_BROADCAST_ID, TOF_SYNC_TIME, time, 0, &status);
+}
+
+int ToF_module::readSync(TofSync &sync)
+{
+    uint8_t result[5];
+    if (read(TOF_SYNC_ERROR, result) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    sync.error = (int16_t)(result[0] | ((uint16_t)result[1] << 8));
+    sync.drift = (int16_t)(result[2] | ((uint16_t)result[3] << 8));
+    sync.count = result[4];
+    return EXIT_SUCCESS;
+}
+
+uint32_t ToF_module::masterTime(uint16_t timestamp)
+{
+    uint32_t now = micros() / 1000;
+    uint16_t age = (uint16_t)now - timestamp;
+    return (now - age) * 1000;
+}
+
+int ToF_module::readProfile(uint8_t bank, bool aux, TofProfile &profile)
+{
+    if (bank == 0 || bank > TOF_PROFILE_COUNT) {
+        return EXIT_FAILURE;
+    }
+    uint8_t page[TOF_PAGE_SIZE];
+    if (readPage(TOF_PAGE_PROFILE + 2 * (bank - 1) + aux, page) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    profile.minRange = (uint16_t)page[0] + ((uint16_t)page[1] << 8);
+    profile.maxRange = (uint16_t)page[2] + ((uint16_t)page[3] << 8);
+    profile.qualityThreshold = (uint16_t)page[4] + ((uint16_t)page[5] << 8);
+    profile.period = (uint32_t)page[6] + ((uint32_t)page[7] << 8)
+        + ((uint32_t)page[8] << 16) + ((uint32_t)page[9] << 24);
+    profile.polling = page[10];
+    profile.adaptivePeriod = page[11];
+    profile.minPeriod = (uint16_t)page[12] + ((uint16_t)page[13] << 8);
+    profile.maxPeriod = (uint16_t)page[14] + ((uint16_t)page[15] << 8);
+    profile.timingBudget = page[16];
+    profile.distanceMode = (TofDistanceMode)page[17];
+    return EXIT_SUCCESS;
+}
+
+int ToF_module::writeProfile(uint8_t bank, bool aux, const TofProfile &profile)
+{
+    if (bank == 0 || bank > TOF_PROFILE_COUNT) {
+        return EXIT_FAILURE;
+    }
+    uint8_t page[TOF_PAGE_SIZE] = { 0, };
+    page[0] = profile.minRange & 0xFF;
+    page[1] = profile.minRange >> 8;
+    page[2] = profile.maxRange & 0xFF;
+    page[3] = profile.maxRange >> 8;
+    page[4] = profile.qualityThreshold & 0xFF;
+    page[5] = profile.qualityThreshold >> 8;
+    page[6] = profile.period & 0xFF;
+    page[7] = (profile.period >> 8) & 0xFF;
+    page[8] = (profile.period >> 16) & 0xFF;
+    page[9] = profile.period >> 24;
+    page[10] = profile.polling;
+    page[11] = profile.adaptivePeriod;
+    page[12] = profile.minPeriod & 0xFF;
+    page[13] = profile.minPeriod >> 8;
+    page[14] = profile.maxPeriod & 0xFF;
+    page[15] = profile.maxPeriod >> 8;
+    page[16] = profile.timingBudget;
+    page[17] = (uint8_t)profile.distanceMode;
+    return writePage(TOF_PAGE_PROFILE + 2 * (bank - 1) + aux, page);
+}
+
+int ToF_module::selectProfile(uint8_t profile)
+{
+    OneWireStatus ret = write(TOF_PROFILE, profile);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::activeProfile(uint8_t &profile)
+{
+    return read(TOF_PROFILE, profile) == OW_STATUS_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+OneWireStatus ToF_module::selectProfileAll(OneWireMInterface &interface, uint8_t profile)
+{
+    uint8_t status;
+    return interface.write(TOF_BROADCAST_ID, TOF_PROFILE, profile, 0, &status);
+}
+
+int ToF_module::readPage(uint8_t page, uint8_t data[TOF_PAGE_SIZE])
+{
+    if (write(TOF_PAGE_SELECT, page) != OW_STATUS_OK || commandError()) {
+        return EXIT_FAILURE;
+    }
+    uint8_t result[TOF_PAGE_SIZE];
+    if (read(TOF_PAGE_DATA, result) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    for (uint8_t i = 0; i < TOF_PAGE_SIZE; i++) {
+        data[i] = result[i];
+    }
+    return EXIT_SUCCESS;
+}
+
+int ToF_module::writePage(uint8_t page, const uint8_t data[TOF_PAGE_SIZE])
+{
+    /* Page selection and data in a single write */
+    uint8_t block[TOF_PAGE_SIZE + 1];
+    block[0] = page;
+    for (uint8_t i = 0; i < TOF_PAGE_SIZE; i++) {
+        block[i + 1] = data[i];
+    }
+    OneWireStatus ret = write(TOF_PAGE_SELECT, block);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::readStatistics(bool aux, TofStatistics &stats)
+{
+    uint8_t page[TOF_PAGE_SIZE];
+    if (readPage(aux ? TOF_PAGE_AUX_STATISTICS : TOF_PAGE_MAIN_STATISTICS, page) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    stats.count = (uint16_t)page[0] + ((uint16_t)page[1] << 8);
+    stats.min = (uint16_t)page[2] + ((uint16_t)page[3] << 8);
+    stats.max = (uint16_t)page[4] + ((uint16_t)page[5] << 8);
+    stats.mean = (uint16_t)page[6] + ((uint16_t)page[7] << 8);
+    stats.variance = (uint32_t)page[8] + ((uint32_t)page[9] << 8)
+        + ((uint32_t)page[10] << 16) + ((uint32_t)page[11] << 24);
+    for (uint8_t i = 0; i < TOF_STATISTICS_RANGE_BINS; i++) {
+        stats.rangeHistogram[i] = page[12 + i];
+    }
+    for (uint8_t i = 0; i < TOF_STATISTICS_QUALITY_BINS; i++) {
+        stats.qualityHistogram[i] = page[20 + i];
+    }
+    stats.tooClose = page[24];
+    stats.noObstacle = page[25];
+    return EXIT_SUCCESS;
+}
+
+int ToF_module::setCalibration(bool aux, int16_t offset, uint16_t gain)
+{
+    uint8_t data[4];
+    data[0] = (uint16_t)offset & 0xFF;
+    data[1] = (uint16_t)offset >> 8;
+    data[2] = gain & 0xFF;
+    data[3] = gain >> 8;
+    OneWireStatus ret = write(aux ? TOF_AUX_CAL_OFFSET : TOF_MAIN_CAL_OFFSET, data);
+    if (ret == OW_STATUS_OK && !commandError()) {
+        return EXIT_SUCCESS;
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+}
+
+int ToF_module::setCalibrationTable(bool aux, const TofCalibrationPoint *points, uint8_t count)
+{
+    if (count > TOF_CALIBRATION_POINTS) {
+        return EXIT_FAILURE;
+    }
+    uint8_t page[TOF_PAGE_SIZE] = { 0, };
+    for (uint8_t i = 0; i < count; i++) {
+        page[4 * i] = points[i].range & 0xFF;
+        page[4 * i + 1] = points[i].range >> 8;
+        page[4 * i + 2] = (uint16_t)points[i].correction & 0xFF;
+        page[4 * i + 3] = (uint16_t)points[i].correction >> 8;
+    }
+    return writePage(aux ? TOF_PAGE_AUX_CALIBRATION : TOF_PAGE_MAIN_CALIBRATION, page);
+}
+
+int ToF_module::readFrame(TofFrame &frame)
+{
+    uint8_t result[8] = { 0, };
+    if (read(TOF_FRAME_SEQ, result) != OW_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    decodeFrame(result, mStatus, mLastFrameSeq, frame);
+    if (!mMainWired) {
+        frame.mainRange = (TofValue)SENSOR_DEAD;
+    }
+    if (!mAuxWired) {
+        frame.auxRange = (TofValue)SENSOR_DEAD;
+    }
+    return EXIT_SUCCESS;
+}
+
+void ToF_module::decodeFrame(const uint8_t data[8], TofStatus status,
+    uint8_t &lastSequence, TofFrame &frame)
+{
+    uint8_t seq = data[0];
+    frame.sequence = seq;
+    frame.fresh = seq != 0 && seq != lastSequence;
+    if (!frame.fresh || lastSequence == 0) {
+        frame.skipped = 0;
+    }
+    else if (seq > lastSequence) {
+        frame.skipped = seq - lastSequence - 1;
+    }
+    else {
+        /* Sequence number wrapped, skipping 0 */
+        frame.skipped = 255 - lastSequence + seq - 1;
+    }
+    lastSequence = seq;
+
+    frame.mainUpdated = frame.fresh && (data[1] & 0x01);
+    frame.auxUpdated = frame.fresh && (data[1] & 0x02);
+    if (status & TOF_STATUS_MAIN_SENSOR_ERROR) {
+        frame.mainRange = (TofValue)SENSOR_DEAD;
+    }
+    else {
+        frame.mainRange = (TofValue)((uint16_t)data[2] + ((uint16_t)data[3] << 8));
+    }
+    if (status & TOF_STATUS_AUX_SENSOR_ERROR) {
+        frame.auxRange = (TofValue)SENSOR_DEAD;
+    }
+    else {
+        frame.auxRange = (TofValue)((uint16_t)data[4] + ((uint16_t)data[5] << 8));
+    }
+    frame.timestamp = (uint16_t)data[6] + ((uint16_t)data[7] << 8);
+}
@@ -3,6 +3,28 @@
 
 #include <stdint.h>
 #include "OneWireMInterface.h"
+#include "ToF_recorder.h"
+
+#define TOF_TRACE_WINDOW_SIZE 16
+#define TOF_TRACE_RECORD_SIZE 4
+#define TOF_PAGE_SIZE 32
+#define TOF_STATISTICS_RANGE_BINS 8
+#define TOF_STATISTICS_QUALITY_BINS 4
+#define TOF_CALIBRATION_POINTS 8
+#define TOF_CALIBRATION_GAIN_ONE 1024
+#define TOF_INDIRECT_SIZE 16
+#define TOF_INDIRECT_UNUSED 0xFF // entry of the indirect table reading as 0
+#define TOF_TIMING_BUDGET_MIN 20 // ms
+#define TOF_TIMING_BUDGET_OVERHEAD 2 // ms, minimal period = budget + overhead
+#define TOF_BROADCAST_ID 0xFE
+#define TOF_TIME_TO_CONTACT_NONE 0xFFFF // no obstacle approaching
+#define TOF_PROFILE_COUNT 3 // banks, profile 0 being the configuration of the registers
+#define TOF_MODULE_F_CPU 8000000 // clock of the module, sets the available baudrates
+#define TOF_BAUDRATE_TOLERANCE 20 // per thousand, same as the module
+#define TOF_BAUDRATE_MAX_VALUE 207 // 9600 baud, highest TOF_BAUDRATE value accepted by the module
+#define TOF_DEFAULT_RETURN_DELAY_TIME 250 // 2 us units, default of the module
+#define TOF_BOOT_TIMEOUT 1000 // ms, wait of init() for the sensors to be powered on
+#define TOF_BOOT_POLL_DELAY 10 // ms
 
 
 typedef int32_t TofValue;
@@ -22,7 +44,9 @@ enum TofStatusEnum {
     TOF_STATUS_INPUT_VOLTAGE_ERROR  = 4,
     TOF_STATUS_RANGE_ERROR          = 8,
     TOF_STATUS_CHECKSUM_ERROR       = 16,
-    TOF_STATUS_INSTRUCTION_ERROR    = 64
+    TOF_STATUS_NEW_DATA             = 32, // not an error, see readRangeIfNew()
+    TOF_STATUS_INSTRUCTION_ERROR    = 64,
+    TOF_STATUS_COLLISION_ALARM      = 128 // not an error, see setCollisionAlarm()
 };
 
 
@@ -68,6 +92,248 @@ enum TofRegisterMap
 
     TOF_INPUT_VOLTAGE = 0x31,
     TOF_LOCK = 0x32,
+
+    /* Adaptive period, EEPROM */
+    TOF_MAIN_ADAPTIVE_PERIOD = 0x33,
+    TOF_MAIN_MIN_PERIOD = 0x34,
+    TOF_MAIN_MAX_PERIOD = 0x36,
+    TOF_AUX_ADAPTIVE_PERIOD = 0x38,
+    TOF_AUX_MIN_PERIOD = 0x39,
+    TOF_AUX_MAX_PERIOD = 0x3B,
+
+    /* Adaptive period, RAM */
+    TOF_MAIN_CURRENT_PERIOD = 0x3D,
+    TOF_MAIN_RANGE_RATE = 0x3F,
+    TOF_AUX_CURRENT_PERIOD = 0x41,
+    TOF_AUX_RANGE_RATE = 0x43,
+
+    /* Interleaved mode, EEPROM */
+    TOF_INTERLEAVED_MODE = 0x45,
+    TOF_MAIN_OFFSET = 0x46,
+    TOF_AUX_OFFSET = 0x48,
+
+    /* Interleaved mode, RAM */
+    TOF_MERGED_MCSLR = 0x4A,
+    TOF_MERGED_RANGE = 0x4B,
+    TOF_MERGED_TIMESTAMP = 0x4D,
+    TOF_MERGED_SOURCE = 0x4F,
+
+    /* Fault recovery, RAM */
+    TOF_MAIN_RECOVERY_COUNT = 0x50,
+    TOF_AUX_RECOVERY_COUNT = 0x51,
+
+    /* Soft reset, EEPROM
+     * A warm reset keeps the configuration and the sensor measurements, and
+     * restarts the synchronization, statistics, counters and schedules */
+    TOF_WARM_RESET = 0x52,
+
+    /* Trace, RAM */
+    TOF_TRACE_COUNT = 0x53,
+    TOF_TRACE_DATA = 0x54,
+
+    /* Statistics, EEPROM */
+    TOF_STATS_WINDOW = 0x64,
+    TOF_STATS_BIN_WIDTH = 0x66,
+
+    /* Statistics, RAM */
+    TOF_STATS_RESET = 0x68,
+
+    /* Page window, RAM */
+    TOF_PAGE_SELECT = 0x69,
+    TOF_PAGE_DATA = 0x6A,
+
+    /* Calibration, EEPROM */
+    TOF_MAIN_CAL_OFFSET = 0x8A,
+    TOF_MAIN_CAL_GAIN = 0x8C,
+    TOF_AUX_CAL_OFFSET = 0x8E,
+    TOF_AUX_CAL_GAIN = 0x90,
+
+    /* Measurement frame, RAM */
+    TOF_FRAME_SEQ = 0x92,
+    TOF_FRAME_UPDATED = 0x93,
+    TOF_FRAME_MAIN_RANGE = 0x94,
+    TOF_FRAME_AUX_RANGE = 0x96,
+    TOF_FRAME_TIMESTAMP = 0x98,
+
+    /* Communication, RAM */
+    TOF_REAL_BAUDRATE = 0x9A,
+
+    /* Outlier rejection, EEPROM */
+    TOF_OUTLIER_GATE = 0x9E,
+    TOF_OUTLIER_CONFIRM = 0xA0,
+
+    /* Outlier rejection, RAM */
+    TOF_MAIN_VALIDITY = 0xA1,
+    TOF_AUX_VALIDITY = 0xA2,
+    TOF_MAIN_REJECT_COUNT = 0xA3,
+    TOF_AUX_REJECT_COUNT = 0xA5,
+
+    /* Idle sleep, EEPROM */
+    TOF_IDLE_SLEEP = 0xA7,
+
+    /* Idle sleep, RAM */
+    TOF_WAKEUP_COUNT = 0xA8,
+    TOF_SLEEP_TIME = 0xAC,
+
+    /* Indirect access, EEPROM */
+    TOF_INDIRECT_ADDRESS = 0xB0,
+
+    /* Indirect access, RAM */
+    TOF_INDIRECT_DATA = 0xC0,
+
+    /* Timing budget, EEPROM */
+    TOF_MAIN_TIMING_BUDGET = 0xD0,
+    TOF_MAIN_DISTANCE_MODE = 0xD1,
+    TOF_AUX_TIMING_BUDGET = 0xD2,
+    TOF_AUX_DISTANCE_MODE = 0xD3,
+
+    /* Timing budget, RAM */
+    TOF_MAIN_MEASURE_RATE = 0xD4,
+    TOF_AUX_MEASURE_RATE = 0xD6,
+
+    /* External trigger, EEPROM */
+    TOF_EXTERNAL_TRIGGER = 0xD8,
+    TOF_TRIGGER_DELAY = 0xD9,
+
+    /* External trigger, RAM */
+    TOF_TRIGGER = 0xDA,
+
+    /* Clock synchronization, RAM */
+    TOF_SYNC_TIME = 0xDB,
+    TOF_SYNC_ERROR = 0xDF,
+    TOF_SYNC_DRIFT = 0xE1,
+    TOF_SYNC_COUNT = 0xE3,
+
+    /* Profiles, RAM */
+    TOF_PROFILE = 0xE4,
+
+    /* Conditional read, EEPROM */
+    TOF_NEW_DATA_SOURCES = 0xE5,
+
+    /* Time to contact, EEPROM */
+    TOF_COLLISION_ALARM = 0xE6,
+
+    /* Time to contact, RAM */
+    TOF_MAIN_TIME_TO_CONTACT = 0xE8,
+    TOF_AUX_TIME_TO_CONTACT = 0xEA,
+};
+
+
+/* Bits of TOF_WIRING_STATUS */
+enum TofWiring
+{
+    TOF_WIRING_MAIN = 0x01,
+    TOF_WIRING_AUX = 0x02,
+    TOF_WIRING_BOOTING = 0x80 // sensors being powered on, the wiring is not known yet
+};
+
+
+/* Bits of TOF_NEW_DATA_SOURCES, data reported by TOF_STATUS_NEW_DATA */
+enum TofNewDataSource
+{
+    TOF_NEW_DATA_MAIN = 0x01, // main range not read yet
+    TOF_NEW_DATA_AUX = 0x02, // aux range not read yet
+    TOF_NEW_DATA_MERGED = 0x04, // merged range not read yet
+    TOF_NEW_DATA_FRAME = 0x08 // frame not read yet
+};
+
+
+enum TofPage
+{
+    TOF_PAGE_MAIN_STATISTICS = 0,
+    TOF_PAGE_AUX_STATISTICS = 1,
+    TOF_PAGE_MAIN_CALIBRATION = 2,
+    TOF_PAGE_AUX_CALIBRATION = 3,
+    TOF_PAGE_PROFILE = 4 // main then aux sensor of each bank, from bank 1
+};
+
+
+/* Statistics over the last complete window of samples. Histograms and the
+ * too close / no obstacle counts are fractions of the window in 1/256 */
+struct TofStatistics
+{
+    uint16_t count;
+    uint16_t min;
+    uint16_t max;
+    uint16_t mean;
+    uint32_t variance;
+    uint8_t rangeHistogram[TOF_STATISTICS_RANGE_BINS];
+    uint8_t qualityHistogram[TOF_STATISTICS_QUALITY_BINS];
+    uint8_t tooClose;
+    uint8_t noObstacle;
+};
+
+
+/* Measurements of one update cycle of the module */
+struct TofFrame
+{
+    uint8_t sequence; // 1 to 255, 0 if no frame was published yet
+    uint8_t skipped; // number of frames published since the previous read and not read
+    bool fresh; // false if this frame was already returned by the previous read
+    bool mainUpdated; // main sensor measured during this cycle
+    bool auxUpdated; // aux sensor measured during this cycle
+    TofValue mainRange;
+    TofValue auxRange;
+    uint16_t timestamp; // ms, master time of the cycle once synchronized, see syncAll()
+};
+
+
+/* State of the clock synchronization of a module */
+struct TofSync
+{
+    uint8_t count; // synchronizations received, 0 if not synchronized
+    int16_t error; // us, error of the module's clock at the last synchronization
+    int16_t drift; // ppm, estimated drift of the module's clock
+};
+
+
+/* Point of a calibration table: correction (mm) to add to the measured
+ * range at the given range (mm) */
+struct TofCalibrationPoint
+{
+    uint16_t range;
+    int16_t correction;
+};
+
+
+/* Classification of the last measurement of a sensor */
+enum TofValidity
+{
+    TOF_VALIDITY_VALID = 0,
+    TOF_VALIDITY_TOO_CLOSE = 1,
+    TOF_VALIDITY_NO_OBSTACLE = 2,
+    TOF_VALIDITY_OUTLIER = 3 // rejected, the range was not updated
+};
+
+
+enum TofDistanceMode
+{
+    TOF_DISTANCE_SHORT = 0,
+    TOF_DISTANCE_LONG = 1
+};
+
+
+/* Configuration of a sensor held in a profile bank */
+struct TofProfile
+{
+    uint16_t minRange; // mm
+    uint16_t maxRange; // mm
+    uint16_t qualityThreshold;
+    uint32_t period; // ms
+    bool polling;
+    bool adaptivePeriod;
+    uint16_t minPeriod; // ms
+    uint16_t maxPeriod; // ms
+    uint8_t timingBudget; // ms
+    TofDistanceMode distanceMode;
+};
+
+
+enum TofInterleavedMode
+{
+    TOF_INTERLEAVED_OFF = 0,
+    TOF_INTERLEAVED_HALF_PERIOD = 1,
+    TOF_INTERLEAVED_ALTERNATE = 2
 };
 
 
@@ -76,10 +342,16 @@ class ToF_module
 public:
     ToF_module(OneWireMInterface &aInterface, uint8_t aId);
 
+    /* After a power up or a soft reset, the module answers before its
+     * sensors are powered on: init() waits for the end of the boot, up to
+     * TOF_BOOT_TIMEOUT, to read which sensors are wired. Returns
+     * OW_STATUS_TIMEOUT if the module is still booting. */
     OneWireStatus init();
 
     TofStatus status() const { return mStatus; }
-    bool error() const { return mStatus != TOF_STATUS_OK; }
+    bool error() const {
+        return (mStatus & ~(TOF_STATUS_NEW_DATA | TOF_STATUS_COLLISION_ALARM)) != TOF_STATUS_OK;
+    }
     bool internalError() const;
     bool commandError() const;
 
@@ -87,7 +359,22 @@ public:
     int setId(uint8_t newId);
     uint16_t model();
     uint8_t firmware();
+    /* Fails if the module cannot generate aBaudrate accurately */
     int communicationSpeed(uint32_t aBaudrate);
+    uint32_t realCommunicationSpeed();
+
+    /* Actual baudrate of the module's UART, and whether it is accurate
+     * enough, for each value of the TOF_BAUDRATE register */
+    static uint32_t moduleBaudrate(uint8_t value);
+    static bool baudrateAccurate(uint8_t value);
+
+    /* Lowest accurate baudrate allowing to call readRange() on moduleCount
+     * modules sharing the bus, each one frequency times per second, while
+     * keeping the bus half free. The bus is also busy while a module waits
+     * for its return delay time (TOF_RETURN_DELAY_TIME register) before
+     * replying. Returns 0 if no baudrate is fast enough. */
+    static uint32_t bestBaudrate(uint8_t moduleCount, uint16_t frequency,
+        uint8_t returnDelayTime = TOF_DEFAULT_RETURN_DELAY_TIME);
     int statusReturnLevel(uint8_t aSRL);
     uint8_t statusReturnLevel() const { return mStatusReturnLevel; }
     bool mainWired() const { return mMainWired; }
@@ -103,31 +390,210 @@ public:
     uint8_t auxAvailable();
     TofValue auxReadRange();
 
+    /* Conditional read: the status of every reply of the module has
+     * TOF_STATUS_NEW_DATA set while one of the selected sources has data
+     * not read yet (none by default: the bit reads as an error to a master
+     * unaware of it). readRangeIfNew() first pings the module, a
+     * status-only exchange, and only reads the range if new data is
+     * reported, so that polling faster than the sensor costs 12 bytes on the
+     * bus per poll instead of 17, but 29 when there is new data. It only
+     * pays off when its sensor is the single source selected with
+     * setNewDataSources(), otherwise the bit does not tell which data is
+     * new and it falls back to a plain readRange(). */
+    int setNewDataSources(uint8_t sources);
+    bool newData() const { return mStatus & TOF_STATUS_NEW_DATA; } // as of the last reply
+    bool pollNewData();
+    TofValue readRangeIfNew();
+    TofValue auxReadRangeIfNew();
+
+    /* Motion: the module filters the range of each sensor into a velocity
+     * (mm/s, negative when the obstacle approaches) and a time to contact
+     * (ms, 0 when too close, TOF_TIME_TO_CONTACT_NONE when nothing
+     * approaches). The status of every reply has TOF_STATUS_COLLISION_ALARM
+     * set while the time to contact of a sensor is below the threshold, so
+     * that a single ping is enough to detect a collision. 0 disables it. */
+    int setCollisionAlarm(uint16_t threshold);
+    bool collisionAlarm() const { return mStatus & TOF_STATUS_COLLISION_ALARM; } // as of the last reply
+    int readMotion(bool aux, int16_t &velocity, uint16_t &timeToContact);
+
+    /* Interleaved mode: both sensors are merged in a single stream */
+    int setInterleaved(TofInterleavedMode mode, int16_t mainOffset = 0,
+        int16_t auxOffset = 0);
+    TofValue mergedReadRange(uint16_t *timestamp = nullptr);
+
+    /* Read and remove up to TOF_TRACE_WINDOW_SIZE / TOF_TRACE_RECORD_SIZE
+     * trace records, return the number of records read. The number of
+     * records that were pending before the read is written in pending. */
+    uint8_t readTrace(uint8_t data[TOF_TRACE_WINDOW_SIZE], uint8_t *pending = nullptr);
+
+    /* Statistics: window is the number of samples per window (0 to publish
+     * after each sample), binWidth the width of the range histogram bins */
+    int setStatistics(uint16_t window, uint16_t binWidth);
+    int resetStatistics(bool main, bool aux);
+    int readStatistics(bool aux, TofStatistics &stats);
+    int readPage(uint8_t page, uint8_t data[TOF_PAGE_SIZE]);
+    int writePage(uint8_t page, const uint8_t data[TOF_PAGE_SIZE]);
+
+    /* Calibration applied by the module to the ranges:
+     * range = (measure + correction(measure)) * gain / TOF_CALIBRATION_GAIN_ONE + offset
+     * The correction is interpolated from a table of up to
+     * TOF_CALIBRATION_POINTS points sorted by increasing range, which is
+     * uploaded in a single write. The raw ranges are not calibrated. */
+    int setCalibration(bool aux, int16_t offset, uint16_t gain = TOF_CALIBRATION_GAIN_ONE);
+    int setCalibrationTable(bool aux, const TofCalibrationPoint *points, uint8_t count);
+
+    /* Outlier rejection: the module only publishes a range if it is within
+     * gate (mm) of the previous one, the gate being narrowed for weak
+     * returns, or once confirm consecutive samples agree on a new range.
+     * A gate of 0 disables the rejection, it is disabled by default. */
+    int setOutlierGate(uint16_t gate, uint8_t confirm);
+    int readValidity(bool aux, TofValidity &validity, uint16_t &rejectCount);
+
+    /* Idle sleep: the module sleeps between its tasks, which lowers its
+     * consumption when measurements are sparse. sleepTime is the total time
+     * spent asleep since startup, in ms. */
+    int setIdleSleep(bool enable);
+    int readSleepStats(uint32_t &wakeups, uint32_t &sleepTime);
+
+    /* Indirect access: the byte i of the TOF_INDIRECT_DATA window reads as
+     * the register addresses[i], so that scattered registers are gathered in
+     * a single short read. The table is stored in the module's EEPROM, the
+     * unused entries are set to TOF_INDIRECT_UNUSED. */
+    int setIndirect(const uint8_t *addresses, uint8_t count);
+
+    /* Read the first sizeof(T) bytes of the indirect window, e.g. in a packed
+     * struct matching the table */
+    template<class T>
+    int readIndirect(T &data)
+    {
+        static_assert(sizeof(T) <= TOF_INDIRECT_SIZE, "larger than the indirect window");
+        return read(TOF_INDIRECT_DATA, data) == OW_STATUS_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Timing budget (ms, from TOF_TIMING_BUDGET_MIN to 255) and distance
+     * mode of a sensor: a longer budget gives a more accurate range at a
+     * lower rate. Fails if the inter-measurement period of the sensor is
+     * not null and shorter than budget + TOF_TIMING_BUDGET_OVERHEAD, the
+     * module would lengthen it. A firmware built without SENSOR_CONFIG_API
+     * keeps the sensors at 33 ms in long range. */
+    int setTimingBudget(bool aux, uint8_t budget, TofDistanceMode mode = TOF_DISTANCE_LONG);
+
+    /* Measurement rate achieved by a sensor, in Hz, 0 if not measuring */
+    float measureRate(bool aux);
+
+    /* External trigger: the sensors only measure once each time they are
+     * triggered, delay (ms) after the trigger. Giving each module of a bus a
+     * different delay, e.g. its ID times the measurement duration, avoids
+     * the optical crosstalk between modules facing each other. */
+    int setExternalTrigger(bool enable, uint8_t delay = 0);
+
+    /* Trigger a single measurement on every module of the bus at once, with
+     * a broadcast write. The modules do not reply. */
+    static OneWireStatus triggerAll(OneWireMInterface &interface,
+        bool main = true, bool aux = true);
+
+    /* Wait for the measurements triggered by triggerAll() and read the
+     * resulting frame of each module. Returns the number of modules whose
+     * frame was read before the timeout (ms), done[i] telling which ones. */
+    static uint8_t gather(ToF_module *modules[], uint8_t count,
+        TofFrame frames[], bool done[], uint32_t timeout);
+
+    /* Clock synchronization: syncAll() broadcasts the master time (micros())
+     * to every module of the bus, which estimate the offset and the drift of
+     * their clock. It should be called at least every few minutes, a second
+     * or so apart. The timestamps published by the modules (frame, merged
+     * range) are then in master time, masterTime() converting them to
+     * micros(). baudrate is the one of the bus, to compensate for the
+     * transmission of the message. */
+    static OneWireStatus syncAll(OneWireMInterface &interface, uint32_t baudrate);
+    int readSync(TofSync &sync);
+
+    /* Master time (us, micros()) of a 16-bit timestamp published by a
+     * synchronized module less than 65 s ago, with a 1 ms resolution */
+    static uint32_t masterTime(uint16_t timestamp);
+
+    /* Configuration profiles: the module holds TOF_PROFILE_COUNT banks
+     * (1 to TOF_PROFILE_COUNT), each one with a profile per sensor. Selecting
+     * a bank applies both profiles at once without writing the module's
+     * EEPROM, profile 0 restoring the configuration of the registers. The
+     * module always starts with profile 0. Writing a bank is stored in
+     * EEPROM, and applied right away if the bank is selected. */
+    int readProfile(uint8_t bank, bool aux, TofProfile &profile);
+    int writeProfile(uint8_t bank, bool aux, const TofProfile &profile);
+    int selectProfile(uint8_t profile);
+    int activeProfile(uint8_t &profile);
+
+    /* Select the same profile on every module of the bus at once, with a
+     * broadcast write. The modules do not reply. */
+    static OneWireStatus selectProfileAll(OneWireMInterface &interface, uint8_t profile);
+
+    /* Read the last measurement frame: the ranges of both sensors are
+     * published together by the module, so that they always come from the
+     * same update cycle. The sequence number is used to detect frames that
+     * were missed, or read twice. */
+    int readFrame(TofFrame &frame);
+
+    /* Decode the TOF_FRAME_SEQ block, lastSequence being the sequence number
+     * of the previous frame read, updated by this call */
+    static void decodeFrame(const uint8_t data[8], TofStatus status,
+        uint8_t &lastSequence, TofFrame &frame);
+
+    /* All the transactions with the module are given to the recorder, if any */
+    void setRecorder(TofRecorder *recorder) { mRecorder = recorder; }
+
     template<class T>
     inline OneWireStatus read(uint8_t aAddress, T& aData)
     {
-        return mInterface.read<T>(mID, aAddress, aData, mStatusReturnLevel, &mStatus);
+        uint32_t start = mRecorder ? micros() : 0;
+        OneWireStatus ret = mInterface.read<T>(mID, aAddress, aData, mStatusReturnLevel, &mStatus);
+        if (mRecorder) {
+            mRecorder->record(start, mID, TOF_RECORD_READ, aAddress, sizeof(T),
+                (const uint8_t*)&aData, ret, mStatus);
+        }
+        return ret;
     }
 
     template<class T>
     inline OneWireStatus write(uint8_t aAddress, const T& aData)
     {
-        return mInterface.write<T>(mID, aAddress, aData, mStatusReturnLevel, &mStatus);
+        uint32_t start = mRecorder ? micros() : 0;
+        OneWireStatus ret = mInterface.write<T>(mID, aAddress, aData, mStatusReturnLevel, &mStatus);
+        if (mRecorder) {
+            mRecorder->record(start, mID, TOF_RECORD_WRITE, aAddress, sizeof(T),
+                (const uint8_t*)&aData, ret, mStatus);
+        }
+        return ret;
     }
 
     OneWireStatus ping()
     {
-        return mInterface.ping(mID, &mStatus);
+        uint32_t start = mRecorder ? micros() : 0;
+        OneWireStatus ret = mInterface.ping(mID, &mStatus);
+        if (mRecorder) {
+            mRecorder->record(start, mID, TOF_RECORD_PING, 0, 0, nullptr, ret, mStatus);
+        }
+        return ret;
     }
 
     OneWireStatus softReset()
     {
-        return mInterface.softReset(mID, mStatusReturnLevel, &mStatus);
+        uint32_t start = mRecorder ? micros() : 0;
+        OneWireStatus ret = mInterface.softReset(mID, mStatusReturnLevel, &mStatus);
+        if (mRecorder) {
+            mRecorder->record(start, mID, TOF_RECORD_SOFT_RESET, 0, 0, nullptr, ret, mStatus);
+        }
+        return ret;
     }
 
     OneWireStatus factoryReset()
     {
-        return mInterface.factoryReset(mID, mStatusReturnLevel, &mStatus);
+        uint32_t start = mRecorder ? micros() : 0;
+        OneWireStatus ret = mInterface.factoryReset(mID, mStatusReturnLevel, &mStatus);
+        mNewDataSources = 0xFF;
+        if (mRecorder) {
+            mRecorder->record(start, mID, TOF_RECORD_FACTORY_RESET, 0, 0, nullptr, ret, mStatus);
+        }
+        return ret;
     }
 
 private:
@@ -137,6 +603,9 @@ private:
     TofStatus mStatus;
     bool mMainWired;
     bool mAuxWired;
+    uint8_t mLastFrameSeq;
+    TofRecorder *mRecorder;
+    uint8_t mNewDataSources; // as last written, 0xFF if unknown
 };
 
 
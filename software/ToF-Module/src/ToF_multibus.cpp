@@ -0,0 +1,201 @@
+#include "ToF_multibus.h"
+#include "ToF_packet.h"
+
+#define FRAME_SIZE 8
+#define REQUEST_SIZE (TOF_PACKET_OVERHEAD + 2) // address and size
+#define REPLY_SIZE (TOF_PACKET_OVERHEAD + FRAME_SIZE)
+#define BITS_PER_BYTE 10
+
+
+ToF_multibus::ToF_multibus()
+{
+    mBusCount = 0;
+    mModuleCount = 0;
+    mCycleStart = 0;
+    mCycleDuration = 0;
+    mCycleComplete = true;
+}
+
+int ToF_multibus::addBus(Stream &serial, uint32_t baudrate, bool echo,
+    uint8_t returnDelayTime)
+{
+    if (mBusCount == TOF_MULTIBUS_MAX_BUSES || baudrate == 0) {
+        return -1;
+    }
+    Bus &bus = mBuses[mBusCount];
+    bus.serial = &serial;
+    bus.echo = echo;
+    /* The timeout starts when the request is queued: it covers the
+     * transmission of the request and of the reply, and the return delay */
+    bus.timeout = (uint32_t)(REQUEST_SIZE + REPLY_SIZE) * BITS_PER_BYTE * 1000000 / baudrate +
+        (uint32_t)returnDelayTime * 2 + TOF_MULTIBUS_TIMEOUT_MARGIN;
+    bus.state = BUS_IDLE;
+    bus.module = -1;
+    return mBusCount++;
+}
+
+int ToF_multibus::addModule(uint8_t bus, uint8_t id, uint8_t wiring)
+{
+    if (bus >= mBusCount || mModuleCount == TOF_MULTIBUS_MAX_MODULES) {
+        return -1;
+    }
+    Module &module = mModules[mModuleCount];
+    module.bus = bus;
+    module.id = id;
+    module.wiring = wiring;
+    module.lastSequence = 0;
+    module.valid = false;
+    module.status = TOF_STATUS_OK;
+    return mModuleCount++;
+}
+
+int ToF_multibus::addModule(uint8_t bus, const ToF_module &module)
+{
+    return addModule(bus, module.id(),
+        (module.mainWired() ? TOF_WIRING_MAIN : 0) | (module.auxWired() ? TOF_WIRING_AUX : 0));
+}
+
+void ToF_multibus::startCycle()
+{
+    uint32_t now = micros();
+    mCycleStart = now;
+    mCycleComplete = false;
+    for (uint8_t i = 0; i < mModuleCount; i++) {
+        mModules[i].valid = false;
+    }
+    for (uint8_t i = 0; i < mBusCount; i++) {
+        Bus &bus = mBuses[i];
+        bus.module = nextModule(i, -1);
+        if (bus.module < 0) {
+            bus.state = BUS_DONE;
+        }
+        else {
+            sendRequest(bus, now);
+        }
+    }
+}
+
+bool ToF_multibus::update()
+{
+    if (mCycleComplete) {
+        return true;
+    }
+    uint32_t now = micros();
+    bool complete = true;
+    for (uint8_t i = 0; i < mBusCount; i++) {
+        Bus &bus = mBuses[i];
+        if (bus.state == BUS_WAITING) {
+            receive(bus, now);
+        }
+        if (bus.state != BUS_DONE) {
+            complete = false;
+        }
+    }
+    if (complete) {
+        mCycleComplete = true;
+        mCycleDuration = now - mCycleStart;
+    }
+    return complete;
+}
+
+bool ToF_multibus::cycleComplete() const
+{
+    return mCycleComplete;
+}
+
+bool ToF_multibus::frame(int handle, TofFrame &frame) const
+{
+    if (handle < 0 || handle >= mModuleCount || !mModules[handle].valid) {
+        return false;
+    }
+    frame = mModules[handle].frame;
+    return true;
+}
+
+TofStatus ToF_multibus::status(int handle) const
+{
+    if (handle < 0 || handle >= mModuleCount) {
+        return TOF_STATUS_OK;
+    }
+    return mModules[handle].status;
+}
+
+void ToF_multibus::sendRequest(Bus &bus, uint32_t now)
+{
+    uint8_t id = mModules[bus.module].id;
+    uint8_t packet[REQUEST_SIZE] = { TOF_PACKET_HEADER, TOF_PACKET_HEADER, id,
+        REQUEST_SIZE - 4, TOF_INSTRUCTION_READ, TOF_FRAME_SEQ, FRAME_SIZE, 0 };
+    packet[REQUEST_SIZE - 1] = tofPacketChecksum(packet, REQUEST_SIZE);
+
+    /* Drop what is left of a previous late reply */
+    while (bus.serial->available() > 0) {
+        bus.serial->read();
+    }
+    bus.serial->write(packet, REQUEST_SIZE);
+    bus.echoLeft = bus.echo ? REQUEST_SIZE : 0;
+    bus.rxLength = 0;
+    bus.requestTime = now;
+    bus.state = BUS_WAITING;
+}
+
+void ToF_multibus::receive(Bus &bus, uint32_t now)
+{
+    bool done = false;
+    while (!done && bus.serial->available() > 0) {
+        uint8_t byte = bus.serial->read();
+        if (bus.echoLeft > 0) {
+            bus.echoLeft--;
+            continue;
+        }
+        if (bus.rxLength < 2 && byte != TOF_PACKET_HEADER) {
+            bus.rxLength = 0;
+            continue;
+        }
+        bus.rx[bus.rxLength++] = byte;
+        if (bus.rxLength == REPLY_SIZE) {
+            done = true;
+        }
+    }
+
+    Module &module = mModules[bus.module];
+    if (done) {
+        if (bus.rx[2] == module.id && bus.rx[3] == REPLY_SIZE - 4 &&
+                tofPacketChecksum(bus.rx, REPLY_SIZE) == bus.rx[REPLY_SIZE - 1]) {
+            module.status = bus.rx[4];
+            ToF_module::decodeFrame(bus.rx + 5, module.status,
+                module.lastSequence, module.frame);
+            /* Same as ToF_module::readFrame() */
+            if (!(module.wiring & TOF_WIRING_MAIN)) {
+                module.frame.mainRange = (TofValue)SENSOR_DEAD;
+            }
+            if (!(module.wiring & TOF_WIRING_AUX)) {
+                module.frame.auxRange = (TofValue)SENSOR_DEAD;
+            }
+            module.valid = true;
+        }
+    }
+    else if (now - bus.requestTime > bus.timeout) {
+        done = true;
+    }
+    else {
+        return;
+    }
+
+    bus.module = nextModule(module.bus, bus.module);
+    if (bus.module < 0) {
+        bus.state = BUS_DONE;
+    }
+    else {
+        sendRequest(bus, now);
+    }
+}
+
+int8_t ToF_multibus::nextModule(uint8_t busIndex, int8_t from) const
+{
+    for (int8_t i = from + 1; i < mModuleCount; i++) {
+        if (mModules[i].bus == busIndex) {
+            return i;
+        }
+    }
+    return -1;
+}
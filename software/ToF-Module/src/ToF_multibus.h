@@ -0,0 +1,109 @@
+#ifndef TOF_MULTIBUS_H
+#define TOF_MULTIBUS_H
+
+#include <Arduino.h>
+#include "ToF_module.h"
+
+#define TOF_MULTIBUS_MAX_BUSES 4
+#define TOF_MULTIBUS_MAX_MODULES 32
+#define TOF_MULTIBUS_TIMEOUT_MARGIN 1000 // us, added to the duration of a transaction
+
+
+/* Reads the measurement frame of many modules spread over several serial
+ * buses, with one transaction in flight on every bus at the same time.
+ *
+ * The OneWireMInterface waits for the reply of each request, so it cannot
+ * drive several buses at once. Instead, the requests are written to the
+ * serial ports directly and the replies are parsed as they arrive, the
+ * transmission and reception being buffered by the serial drivers (interrupt
+ * or DMA driven, depending on the platform). update() never blocks.
+ *
+ * A control cycle reads the frame of every module once. The duration of a
+ * cycle is the one of the most loaded bus, so the modules should be spread
+ * evenly over the buses.
+ *
+ * The buses must already be configured (baudrate, half-duplex mode) and
+ * must not be used by another interface during a cycle. The baudrate and
+ * the return delay time of the modules (2 us units) set the timeout of a
+ * transaction. On buses where the master receives its own transmission, set
+ * echo to skip it.
+ *
+ * The packets follow ToF_packet.h, the format of OneWireMInterface.
+ */
+class ToF_multibus
+{
+public:
+    ToF_multibus();
+
+    /* Return the index of the bus, or -1 */
+    int addBus(Stream &serial, uint32_t baudrate, bool echo = false,
+        uint8_t returnDelayTime = TOF_DEFAULT_RETURN_DELAY_TIME);
+
+    /* Return the handle of the module, or -1. The ranges of the sensors
+     * which are not wired (TofWiring bits, see ToF_module::init()) read as
+     * SENSOR_DEAD. */
+    int addModule(uint8_t bus, uint8_t id, uint8_t wiring = TOF_WIRING_MAIN | TOF_WIRING_AUX);
+    int addModule(uint8_t bus, const ToF_module &module);
+
+    /* Start a control cycle, the previous one being aborted if needed */
+    void startCycle();
+
+    /* Make the transactions progress on every bus, return true when the
+     * current cycle is complete */
+    bool update();
+
+    bool cycleComplete() const;
+    uint32_t cycleDuration() const { return mCycleDuration; } // us, last complete cycle
+
+    /* Result of the current cycle for a module. Returns false if the module
+     * was not read yet or did not answer correctly. */
+    bool frame(int handle, TofFrame &frame) const;
+    TofStatus status(int handle) const;
+
+private:
+    enum BusState
+    {
+        BUS_IDLE,
+        BUS_WAITING,
+        BUS_DONE
+    };
+
+    struct Bus
+    {
+        Stream *serial;
+        bool echo;
+        uint32_t timeout;
+        BusState state;
+        int8_t module; // module currently read, index in mModules
+        uint32_t requestTime;
+        uint8_t echoLeft;
+        uint8_t rxLength;
+        uint8_t rx[16];
+    };
+
+    struct Module
+    {
+        uint8_t bus;
+        uint8_t id;
+        uint8_t wiring;
+        uint8_t lastSequence;
+        bool valid;
+        TofStatus status;
+        TofFrame frame;
+    };
+
+    void sendRequest(Bus &bus, uint32_t now);
+    void receive(Bus &bus, uint32_t now);
+    int8_t nextModule(uint8_t busIndex, int8_t from) const;
+
+    Bus mBuses[TOF_MULTIBUS_MAX_BUSES];
+    uint8_t mBusCount;
+    Module mModules[TOF_MULTIBUS_MAX_MODULES];
+    uint8_t mModuleCount;
+    uint32_t mCycleStart;
+    uint32_t mCycleDuration;
+    bool mCycleComplete;
+};
+
+
+#endif
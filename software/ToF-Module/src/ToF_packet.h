@@ -0,0 +1,35 @@
+#ifndef TOF_PACKET_H
+#define TOF_PACKET_H
+
+#include <stdint.h>
+
+/* Packet format of the OneWire protocol (Dynamixel protocol 1.0), as sent
+ * and parsed by OneWireMInterface and OneWireSInterface:
+ *   FF FF ID LENGTH INSTRUCTION PARAMETERS... CHECKSUM (request)
+ *   FF FF ID LENGTH STATUS DATA... CHECKSUM (reply)
+ * LENGTH counts the bytes after it, and CHECKSUM is the complement of the
+ * sum of the bytes from ID. Only needed by the transactions which cannot go
+ * through OneWireMInterface, see ToF_multibus. */
+#define TOF_PACKET_HEADER 0xFF
+#define TOF_PACKET_OVERHEAD 6 // bytes of a packet besides the parameters or data
+
+enum TofInstruction
+{
+    TOF_INSTRUCTION_PING = 0x01,
+    TOF_INSTRUCTION_READ = 0x02,
+    TOF_INSTRUCTION_WRITE = 0x03,
+    TOF_INSTRUCTION_FACTORY_RESET = 0x06,
+    TOF_INSTRUCTION_SOFT_RESET = 0x08
+};
+
+static inline uint8_t tofPacketChecksum(const uint8_t *packet, uint8_t size)
+{
+    uint8_t sum = 0;
+    for (uint8_t i = 2; i < size - 1; i++) {
+        sum += packet[i];
+    }
+    return ~sum;
+}
+
+
+#endif
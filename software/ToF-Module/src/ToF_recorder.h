@@ -0,0 +1,76 @@
+#ifndef TOF_RECORDER_H
+#define TOF_RECORDER_H
+
+#include <Arduino.h>
+#include "ToF_packet.h"
+
+/* Capture of the bus traffic, one record per transaction:
+ *   offset  size  content
+ *   0       4     start of the transaction, us (master clock, little endian)
+ *   4       1     module ID
+ *   5       1     instruction (TofRecordInstruction)
+ *   6       1     register address (read, write)
+ *   7       1     data size
+ *   8       1     communication status (OneWireStatus, 0 if OK)
+ *   9       1     status byte returned by the module
+ *   10      size  data written, or data read
+ * A capture file starts with TOF_CAPTURE_MAGIC followed by
+ * TOF_CAPTURE_VERSION. Captures can be replayed on the host-built firmware
+ * with software/tools/replay. */
+#define TOF_CAPTURE_MAGIC "TOFC"
+#define TOF_CAPTURE_VERSION 1
+#define TOF_RECORD_HEADER_SIZE 10
+
+enum TofRecordInstruction
+{
+    TOF_RECORD_PING = TOF_INSTRUCTION_PING,
+    TOF_RECORD_READ = TOF_INSTRUCTION_READ,
+    TOF_RECORD_WRITE = TOF_INSTRUCTION_WRITE,
+    TOF_RECORD_FACTORY_RESET = TOF_INSTRUCTION_FACTORY_RESET,
+    TOF_RECORD_SOFT_RESET = TOF_INSTRUCTION_SOFT_RESET
+};
+
+
+class TofRecorder
+{
+public:
+    virtual void record(uint32_t timestamp, uint8_t id, uint8_t instruction,
+        uint8_t address, uint8_t size, const uint8_t *data, uint8_t comStatus,
+        uint8_t status) = 0;
+};
+
+
+/* Writes the capture on a Print (SD card file, spare serial port...) */
+class TofStreamRecorder : public TofRecorder
+{
+public:
+    TofStreamRecorder(Print &output) : mOutput(output) {}
+
+    /* Write the file header, to call once before the first record */
+    void begin()
+    {
+        mOutput.write((const uint8_t*)TOF_CAPTURE_MAGIC, 4);
+        mOutput.write((uint8_t)TOF_CAPTURE_VERSION);
+    }
+
+    void record(uint32_t timestamp, uint8_t id, uint8_t instruction,
+        uint8_t address, uint8_t size, const uint8_t *data, uint8_t comStatus,
+        uint8_t status) override
+    {
+        uint8_t header[TOF_RECORD_HEADER_SIZE] = {
+            (uint8_t)timestamp, (uint8_t)(timestamp >> 8),
+            (uint8_t)(timestamp >> 16), (uint8_t)(timestamp >> 24),
+            id, instruction, address, size, comStatus, status
+        };
+        mOutput.write(header, TOF_RECORD_HEADER_SIZE);
+        if (size > 0) {
+            mOutput.write(data, size);
+        }
+    }
+
+private:
+    Print &mOutput;
+};
+
+
+#endif
@@ -0,0 +1,183 @@
+#include <Arduino.h>
+#include "ToF_scheduler.h"
+
+/* Delay between two probes of a sensor, as a fraction of its period */
+#define PROBE_PERIOD_DIVIDER 4
+
+
+ToF_scheduler::ToF_scheduler() :
+    mPreemptions(0)
+{
+    for (uint8_t i = 0; i < TOF_SCHEDULER_MAX_ENTRIES; i++) {
+        mEntries[i].module = nullptr;
+    }
+}
+
+int ToF_scheduler::add(ToF_module &module, bool aux, float rate, uint8_t priority)
+{
+    if (rate <= 0) {
+        return -1;
+    }
+    if (aux ? !module.auxWired() : !module.mainWired()) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < TOF_SCHEDULER_MAX_ENTRIES; i++) {
+        Entry &entry = mEntries[i];
+        if (entry.module == nullptr) {
+            uint32_t now = millis();
+            entry.module = &module;
+            entry.aux = aux;
+            entry.priority = priority;
+            entry.period = max((uint32_t)(1000 / rate), (uint32_t)1);
+            entry.nextDue = now;
+            entry.lastSample = now;
+            entry.interval = entry.period;
+            entry.probing = false;
+            entry.ready = false;
+            entry.fresh = false;
+            entry.range = (TofValue)SENSOR_NOT_UPDATED;
+            entry.samples = 0;
+            entry.transactions = 0;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void ToF_scheduler::remove(int handle)
+{
+    if (handle >= 0 && handle < TOF_SCHEDULER_MAX_ENTRIES) {
+        mEntries[handle].module = nullptr;
+    }
+}
+
+int ToF_scheduler::update()
+{
+    uint32_t now = millis();
+    int handle = next(now);
+    if (handle < 0) {
+        return -1;
+    }
+    return poll(mEntries[handle], now) ? handle : -1;
+}
+
+TofValue ToF_scheduler::range(int handle) const
+{
+    if (handle < 0 || handle >= TOF_SCHEDULER_MAX_ENTRIES || mEntries[handle].module == nullptr) {
+        return (TofValue)SENSOR_NOT_UPDATED;
+    }
+    return mEntries[handle].range;
+}
+
+bool ToF_scheduler::newValue(int handle)
+{
+    if (handle < 0 || handle >= TOF_SCHEDULER_MAX_ENTRIES || mEntries[handle].module == nullptr) {
+        return false;
+    }
+    bool fresh = mEntries[handle].fresh;
+    mEntries[handle].fresh = false;
+    return fresh;
+}
+
+TofScheduleStats ToF_scheduler::stats(int handle) const
+{
+    TofScheduleStats stats = { 0, 0, 0, 0 };
+    if (handle < 0 || handle >= TOF_SCHEDULER_MAX_ENTRIES || mEntries[handle].module == nullptr) {
+        return stats;
+    }
+    const Entry &entry = mEntries[handle];
+    /* A sensor which stopped giving values sees its rate decrease */
+    uint32_t interval = max(entry.interval, (uint32_t)(millis() - entry.lastSample));
+    stats.requestedRate = 1000.0 / entry.period;
+    stats.achievedRate = entry.samples == 0 ? 0 : 1000.0 / max(interval, (uint32_t)1);
+    stats.samples = entry.samples;
+    stats.transactions = entry.transactions;
+    return stats;
+}
+
+int ToF_scheduler::next(uint32_t now)
+{
+    int best = -1;
+    int32_t bestLateness = 0;
+    int latest = -1;
+    int32_t latestLateness = 0;
+    for (uint8_t i = 0; i < TOF_SCHEDULER_MAX_ENTRIES; i++) {
+        const Entry &entry = mEntries[i];
+        int32_t lateness = (int32_t)(now - entry.nextDue);
+        if (entry.module == nullptr || lateness < 0) {
+            continue;
+        }
+        if (best < 0 || entry.priority > mEntries[best].priority ||
+                (entry.priority == mEntries[best].priority && lateness > bestLateness)) {
+            best = i;
+            bestLateness = lateness;
+        }
+        if (latest < 0 || lateness > latestLateness) {
+            latest = i;
+            latestLateness = lateness;
+        }
+    }
+
+    /* The most late sensor is only of lower priority than the best one when
+     * it is passed over */
+    if (best != latest) {
+        if (mPreemptions >= TOF_SCHEDULER_MAX_PREEMPTIONS) {
+            mPreemptions = 0;
+            return latest;
+        }
+        mPreemptions++;
+    }
+    else {
+        mPreemptions = 0;
+    }
+    return best;
+}
+
+bool ToF_scheduler::poll(Entry &entry, uint32_t now)
+{
+    uint32_t probePeriod = max(entry.period / PROBE_PERIOD_DIVIDER, (uint32_t)1);
+    entry.transactions++;
+
+    if (entry.probing && !entry.ready) {
+        uint8_t count = entry.aux ? entry.module->auxAvailable() : entry.module->available();
+        if (count > 0) {
+            entry.ready = true;
+            entry.nextDue = now;
+        }
+        else {
+            entry.nextDue = now + probePeriod;
+        }
+        return false;
+    }
+
+    /* Same request as readRange(), whose result does not tell a failed
+     * transaction from a value not ready */
+    uint8_t result[3] = { 0, };
+    OneWireStatus ret = entry.module->read(entry.aux ? TOF_AUX_MCSLR : TOF_MAIN_MCSLR, result);
+    entry.ready = false;
+    if (ret == OW_STATUS_OK &&
+            (entry.module->status() & (entry.aux ? TOF_STATUS_AUX_SENSOR_ERROR : TOF_STATUS_MAIN_SENSOR_ERROR))) {
+        /* Reported, but not counted as a sample */
+        entry.probing = false;
+        entry.range = (TofValue)SENSOR_DEAD;
+        entry.fresh = true;
+        entry.nextDue = now + entry.period;
+        return true;
+    }
+    if (ret != OW_STATUS_OK || result[0] == 0) {
+        entry.probing = true;
+        entry.nextDue = now + probePeriod;
+        return false;
+    }
+
+    entry.probing = false;
+    entry.fresh = true;
+    entry.range = (TofValue)((uint16_t)result[1] + ((uint16_t)result[2] << 8));
+    if (entry.samples > 0) {
+        entry.interval = (3 * entry.interval + (now - entry.lastSample)) / 4;
+    }
+    entry.samples++;
+    entry.lastSample = now;
+    entry.nextDue = now + entry.period;
+    return true;
+}
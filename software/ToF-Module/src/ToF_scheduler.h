@@ -0,0 +1,78 @@
+#ifndef TOF_SCHEDULER_H
+#define TOF_SCHEDULER_H
+
+#include <stdint.h>
+#include "ToF_module.h"
+
+#define TOF_SCHEDULER_MAX_ENTRIES 16
+/* Number of transactions a due sensor can be passed over by sensors of
+ * higher priority */
+#define TOF_SCHEDULER_MAX_PREEMPTIONS 4
+
+
+/* Bus usage of one scheduled sensor */
+struct TofScheduleStats
+{
+    float requestedRate; // Hz
+    float achievedRate; // Hz, averaged over the last samples
+    uint32_t samples; // number of new values read
+    uint32_t transactions; // number of bus transactions performed
+};
+
+
+/* Polls the sensors of several modules sharing a bus, one transaction per
+ * call to update(), so that each sensor is read at its requested rate.
+ *
+ * When several sensors are due, the one with the highest priority is served
+ * first, then the most late one. A sensor that is due is not passed over
+ * more than TOF_SCHEDULER_MAX_PREEMPTIONS times in a row, so that sensors of
+ * higher priority cannot starve it. When a sensor had no new value at its due
+ * time, it is probed with the cheaper available() request until a value is
+ * ready, instead of reading the full range each time. A failed transaction
+ * is retried like a probe, and is not counted as a sample.
+ * Sensors that are not wired (see ToF_module::init()) are never polled.
+ */
+class ToF_scheduler
+{
+public:
+    ToF_scheduler();
+
+    /* Return the handle of the sensor, or -1 if it cannot be scheduled */
+    int add(ToF_module &module, bool aux, float rate, uint8_t priority = 0);
+    void remove(int handle);
+
+    /* Perform at most one bus transaction. Return the handle of the sensor
+     * if a new value was read, -1 otherwise. */
+    int update();
+
+    TofValue range(int handle) const;
+    bool newValue(int handle); // true once for each new value read
+    TofScheduleStats stats(int handle) const;
+
+private:
+    struct Entry
+    {
+        ToF_module *module;
+        bool aux;
+        uint8_t priority;
+        uint32_t period; // ms
+        uint32_t nextDue; // ms
+        uint32_t lastSample; // ms
+        uint32_t interval; // ms, filtered interval between two samples
+        bool probing; // value not ready at due time, probe with available()
+        bool ready; // a probe found a value, read it as soon as possible
+        bool fresh;
+        TofValue range;
+        uint32_t samples;
+        uint32_t transactions;
+    };
+
+    int next(uint32_t now);
+    bool poll(Entry &entry, uint32_t now);
+
+    Entry mEntries[TOF_SCHEDULER_MAX_ENTRIES];
+    uint8_t mPreemptions; // consecutive transactions passing over a due sensor
+};
+
+
+#endif
@@ -11,11 +11,15 @@
 #include <OneWireSInterface.h>
 #include "register_storage.h"
 #include "sensor_mgr.h"
+#include "sync_clock.h"
+#include "trace.h"
 #include "utils.h"
 #include <SoftwareSerial.h>
+#include <avr/sleep.h>
 
-#define DEBUG 1
-#define INPUT_VOLTAGE_UPDATE_PERIOD 10000 // ms
+#define DEBUG 0 // text output on the debug serial, this distorts the timings
+#define DEBUG_TRACE 0 // binary trace records on the debug serial, sent when idle
+#define VCC_MAX_AGE 100 // ms, an input voltage measurement is reused by the reads within this delay
 
 
 enum ErrCode
@@ -27,42 +31,225 @@ enum ErrCode
     INSTRUCTION_ERROR = 64,
 };
 
-#if DEBUG
+#if DEBUG || DEBUG_TRACE
 SoftwareSerial debug(PIN_DEBUG_C, PIN_DEBUG_D);
 #endif
 static RegisterStorage registers(RANGE_ERROR);
+static SyncClock syncClock(registers);
 #if DEBUG
 static OneWireSInterface slaveInterface(Serial, INSTRUCTION_ERROR, CHECKSUM_ERROR, OneWireInterface::NO_DIR_PORT, &debug);
-static SensorMgr sensorMgr(registers, &debug);
+static SensorMgr sensorMgr(registers, syncClock, &debug);
 #else
 static OneWireSInterface slaveInterface(Serial, INSTRUCTION_ERROR, CHECKSUM_ERROR, OneWireInterface::NO_DIR_PORT);
-static SensorMgr sensorMgr(registers);
+static SensorMgr sensorMgr(registers, syncClock);
 #endif
 bool running;
 bool f_reset_requested;
+bool f_warm_reset;
+bool f_communication_changed;
+uint8_t communication[4]; // settings in use, REG_ID to REG_STATUS_RETURN_LEVEL
+uint32_t request_time; // us, reception of the request being handled
+uint32_t loop_time; // us, start of the main loop iteration
+uint32_t wakeup_count;
+uint32_t sleep_time; // ms
+uint16_t sleep_time_us; // remainder of sleep_time
 
 
-void read(uint8_t address, uint8_t size, uint8_t *data)
+/* Register hooks, see RegisterStorage::setHooks() */
+
+uint8_t communication_written(uint8_t, uint8_t)
+{
+    /* Applied by the main loop once the reply is sent */
+    f_communication_changed = true;
+    return 0;
+}
+
+void main_range_read(uint8_t, uint8_t)
 {
-    registers.read(address, size, data);
-    if (check_buffer_intersect(address, size, REG_MAIN_RANGE, 6)) {
-        sensorMgr.resetMainMeasureCount();
+    sensorMgr.resetMainMeasureCount();
+}
+
+void aux_range_read(uint8_t, uint8_t)
+{
+    sensorMgr.resetAuxMeasureCount();
+}
+
+void load_input_voltage(uint8_t, uint8_t)
+{
+    /* The conversion runs in the reply path, the register being part of the
+     * usual reads: a recent value is reused, and only changes are traced */
+    static uint32_t vcc_time = 0;
+    static uint8_t vcc_value = 0;
+    uint32_t now = millis();
+    if (vcc_value != 0 && now - vcc_time < VCC_MAX_AGE) {
+        return;
+    }
+    vcc_time = now;
+    uint8_t vcc = read_vcc() / 40;
+    registers.writeRAM(REG_INPUT_VOLTAGE, vcc);
+    if (vcc != vcc_value) {
+        vcc_value = vcc;
+        TRACE(TRACE_VCC, vcc);
     }
-    if (check_buffer_intersect(address, size, REG_AUX_RANGE, 6)) {
-        sensorMgr.resetAuxMeasureCount();
+}
+
+void merged_range_read(uint8_t, uint8_t)
+{
+    sensorMgr.resetMergedMeasureCount();
+}
+
+void load_trace(uint8_t address, uint8_t size)
+{
+    /* Trace records are removed from the buffer only if the whole window is
+     * read */
+    uint8_t window[TRACE_WINDOW_SIZE] = { 0, };
+    registers.writeRAM(REG_TRACE_COUNT, trace.available());
+    if (address <= REG_TRACE_DATA &&
+            address + size >= REG_TRACE_DATA + TRACE_WINDOW_SIZE) {
+        trace.pop(window, TRACE_WINDOW_SIZE);
     }
+    registers.writeRAM(REG_TRACE_DATA, TRACE_WINDOW_SIZE, window);
+}
+
+void load_page(uint8_t, uint8_t)
+{
+    uint8_t page;
+    registers.read(REG_PAGE_SELECT, page);
+    switch (page) {
+    case PAGE_MAIN_STATISTICS:
+        registers.loadPage(sensorMgr.mainStatistics().published(), STATS_SIZE);
+        break;
+    case PAGE_AUX_STATISTICS:
+        registers.loadPage(sensorMgr.auxStatistics().published(), STATS_SIZE);
+        break;
+    case PAGE_MAIN_CALIBRATION:
+        registers.loadEEPROMPage(EEPROM_PAGE_MAIN_CALIBRATION);
+        break;
+    case PAGE_AUX_CALIBRATION:
+        registers.loadEEPROMPage(EEPROM_PAGE_AUX_CALIBRATION);
+        break;
+    default:
+        if (page >= PAGE_PROFILE && page < PAGE_COUNT) {
+            registers.loadProfile((page - PAGE_PROFILE) / 2 + 1, (page - PAGE_PROFILE) % 2);
+        }
+        else {
+            registers.loadPage(nullptr, 0);
+        }
+        break;
+    }
+}
+
+uint8_t store_page(uint8_t, uint8_t)
+{
+    uint8_t page;
+    registers.read(REG_PAGE_SELECT, page);
+    switch (page) {
+    case PAGE_MAIN_CALIBRATION:
+        registers.storeEEPROMPage(EEPROM_PAGE_MAIN_CALIBRATION);
+        break;
+    case PAGE_AUX_CALIBRATION:
+        registers.storeEEPROMPage(EEPROM_PAGE_AUX_CALIBRATION);
+        break;
+    default:
+        if (page >= PAGE_PROFILE && page < PAGE_COUNT) {
+            return registers.storeProfile((page - PAGE_PROFILE) / 2 + 1, (page - PAGE_PROFILE) % 2);
+        }
+        /* Read-only page */
+        break;
+    }
+    return 0;
+}
+
+void frame_read(uint8_t, uint8_t)
+{
+    sensorMgr.frameRead();
+}
+
+uint8_t trigger_written(uint8_t, uint8_t)
+{
+    sensorMgr.trigger();
+    return 0;
+}
+
+uint8_t sync_time_written(uint8_t, uint8_t)
+{
+    /* The request waited in the UART buffer at most since the start of the
+     * loop iteration */
+    syncClock.synchronize(request_time, request_time - loop_time);
+    return 0;
+}
+
+uint8_t profile_written(uint8_t, uint8_t)
+{
+    uint8_t profile;
+    registers.read(REG_PROFILE, profile);
+    registers.selectProfile(profile);
+    return 0;
+}
+
+/* Indexed by Hook: prepare read, finish read, written */
+static const HookHandlers hooks[HOOK_COUNT] PROGMEM = {
+    { nullptr, nullptr, nullptr },
+    { nullptr, nullptr, communication_written },
+    { nullptr, main_range_read, nullptr },
+    { nullptr, aux_range_read, nullptr },
+    { load_input_voltage, nullptr, nullptr },
+    { nullptr, merged_range_read, nullptr },
+    { load_trace, nullptr, nullptr },
+    { load_page, nullptr, store_page },
+    { nullptr, frame_read, nullptr },
+    { nullptr, nullptr, trigger_written },
+    { nullptr, nullptr, sync_time_written },
+    { nullptr, nullptr, profile_written },
+};
+
+void read(uint8_t address, uint8_t size, uint8_t *data)
+{
+    TRACE(TRACE_READ, address);
+    registers.masterRead(address, size, data);
+    /* The reply reports whether data is left after this read */
+    slaveInterface.setHardwareStatus(sensorMgr.status());
 }
 
 uint8_t write(uint8_t address, uint8_t size, const uint8_t *data)
 {
+    request_time = micros();
+    TRACE(TRACE_WRITE, address);
     return registers.write(address, size, data);
 }
 
+/* Apply the communication settings of the registers which differ from the
+ * ones in use, or all of them at startup */
+void update_communication(bool startup)
+{
+    uint8_t settings[4]; // REG_ID, REG_BAUDRATE, REG_RETURN_DELAY_TIME, REG_STATUS_RETURN_LEVEL
+    registers.read(REG_ID, settings);
+    if (startup || settings[1] != communication[1]) {
+        if (!startup) {
+            TRACE(TRACE_BAUDRATE, settings[1]);
+            slaveInterface.end();
+        }
+        slaveInterface.begin(baudrate(settings[1]));
+        registers.writeRAM(REG_REAL_BAUDRATE, real_baudrate(settings[1]));
+    }
+    if (startup || settings[0] != communication[0]) {
+        slaveInterface.setID(settings[0]);
+    }
+    if (startup || settings[2] != communication[2]) {
+        slaveInterface.setRDT((uint32_t)settings[2] * 2);
+    }
+    if (startup || settings[3] != communication[3]) {
+        slaveInterface.setSRL(settings[3]);
+    }
+    memcpy(communication, settings, sizeof(settings));
+}
+
 void factory_reset()
 {
 #if DEBUG
     debug.println("factory reset");
 #endif
+    TRACE(TRACE_FACTORY_RESET, 0);
     f_reset_requested = true;
     running = false;
 }
@@ -72,6 +259,8 @@ void soft_reset()
 #if DEBUG
     debug.println("soft reset");
 #endif
+    TRACE(TRACE_SOFT_RESET, 0);
+    registers.read(REG_WARM_RESET, f_warm_reset);
     running = false;
 }
 
@@ -82,6 +271,7 @@ void main_sensor_ready()
     led_state = !led_state;
     digitalWrite(PIN_DEBUG_A, led_state);
 #endif
+    TRACE(TRACE_SENSOR_READY, 0);
 
     sensorMgr.mainSensorReady();
 }
@@ -93,20 +283,70 @@ void aux_sensor_ready()
     led_state = !led_state;
     digitalWrite(PIN_DEBUG_B, led_state);
 #endif
+    TRACE(TRACE_SENSOR_READY, 1);
 
     sensorMgr.auxSensorReady();
 }
 
+/* Idle sleep: when nothing is due, the CPU is stopped until the next
+ * interrupt, the peripherals keep running. The wakeup sources are the UART,
+ * the interrupt lines of the sensors, and the timer 0 of millis() which
+ * ticks every 1.024 ms, so that the timeouts of the communication are still
+ * checked. Register changes made by the master are applied at the next
+ * wakeup at the latest. */
+void idle_sleep(uint32_t idle_time)
+{
+    bool enabled;
+    registers.read(REG_IDLE_SLEEP, enabled);
+    if (!enabled || idle_time == 0 || slaveInterface.waitingToSendPacket()) {
+        return;
+    }
+#if DEBUG_TRACE
+    if (trace.available() > 0) {
+        return;
+    }
+#endif
+
+    uint32_t start = micros();
+    bool slept = false;
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    noInterrupts();
+    /* Check again with interrupts disabled: a byte or a measurement may have
+     * arrived since idle_time was computed. The instruction following sei
+     * is executed before any pending interrupt, so none can be missed
+     * between these checks and the sleep. */
+    if (Serial.available() == 0 && sensorMgr.idleTime(millis()) > 0) {
+        sleep_enable();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+        slept = true;
+    }
+    interrupts();
+
+    if (slept) {
+        uint32_t duration = micros() - start + sleep_time_us;
+        wakeup_count++;
+        sleep_time += duration / 1000;
+        sleep_time_us = duration % 1000;
+        registers.writeRAM(REG_WAKEUP_COUNT, wakeup_count);
+        registers.writeRAM(REG_SLEEP_TIME, sleep_time);
+    }
+}
+
 void setup()
 {
-#if DEBUG
+#if DEBUG || DEBUG_TRACE
     debug.begin(115200);
+#endif
+#if DEBUG
     debug.println("Debug serial");
     pinMode(PIN_DEBUG_A, OUTPUT);
     pinMode(PIN_DEBUG_B, OUTPUT);
     pinMode(LED_BUILTIN, OUTPUT);
     digitalWrite(LED_BUILTIN, LOW);
 #endif
+    registers.setHooks(hooks);
     slaveInterface.setReadCallback(read);
     slaveInterface.setWriteCallback(write);
     slaveInterface.setSoftResetCallback(soft_reset);
@@ -119,40 +359,56 @@ void setup()
 
 void loop()
 {
-    uint32_t last_vcc_update = 0;
     uint32_t now;
     running = true;
     f_reset_requested = false;
-    registers.init();
-    sensorMgr.begin();
-    slaveInterface.begin(baudrate(registers.getBaudrate()));
-    slaveInterface.setID(registers.getId());
-    slaveInterface.setRDT((uint32_t)registers.getReturnDelayTime() * 2);
-    slaveInterface.setSRL(registers.getStatusReturnLevel());
+    f_communication_changed = false;
+    TRACE(TRACE_START, f_warm_reset);
+    if (f_warm_reset) {
+        /* Keep the configuration registers and the running sensors with
+         * their last measurements. The communication with the master, the
+         * clock synchronization, the statistics, the counters and the
+         * trigger schedules restart as after a cold reset. The trace buffer
+         * is kept by both resets, TRACE_START marking them. */
+        registers.writeRAM(REG_LOCK, (uint8_t)0);
+        syncClock.reset();
+        sensorMgr.warmReset();
+        wakeup_count = 0;
+        sleep_time = 0;
+        sleep_time_us = 0;
+        registers.writeRAM(REG_WAKEUP_COUNT, wakeup_count);
+        registers.writeRAM(REG_SLEEP_TIME, sleep_time);
+    }
+    else {
+        registers.init();
+        syncClock.reset();
+        sensorMgr.begin();
+        wakeup_count = 0;
+        sleep_time = 0;
+        sleep_time_us = 0;
+    }
+    update_communication(true);
 
 #if DEBUG
-    debug.println("Registers:");
-    uint8_t d[51];
-    registers.read(0, 51, d);
-    for (size_t i = 0; i < 51; i++) {
-        debug.print(i);
-        debug.print("\t");
-        debug.println(d[i]);
-    }
-    debug.println("-end-");
+    if (!f_warm_reset) {
+        debug.println("Registers:");
+        uint8_t d[REGISTER_SIZE];
+        registers.read(0, REGISTER_SIZE, d);
+        for (size_t i = 0; i < REGISTER_SIZE; i++) {
+            debug.print(i);
+            debug.print("\t");
+            debug.println(d[i]);
+        }
+        debug.println("-end-");
+    }
 #endif
+    f_warm_reset = false;
 
     while (running) {
-        /* Input voltage update */
-        now = millis();
-        if (now - last_vcc_update > INPUT_VOLTAGE_UPDATE_PERIOD) {
-            last_vcc_update = now;
-            long vcc = read_vcc();
-            vcc /= 40;
-            registers.writeRAM(REG_INPUT_VOLTAGE, (uint8_t)vcc);
-        }
+        loop_time = micros();
 
         /* Sensors update */
+        syncClock.update(loop_time);
         sensorMgr.update();
         slaveInterface.setHardwareStatus(sensorMgr.status());
 
@@ -160,25 +416,27 @@ void loop()
         slaveInterface.communicate();
 
         /* Update slaveInterface settings if needed */
-        if (!slaveInterface.waitingToSendPacket()) {
-            if (registers.idChanged()) {
-                slaveInterface.setID(registers.getId());
-            }
-            if (registers.baudrateChanged()) {
-                slaveInterface.end();
-                slaveInterface.begin(baudrate(registers.getBaudrate()));
-            }
-            if (registers.returnDelayTimeChanged()) {
-                slaveInterface.setRDT((uint32_t)registers.getReturnDelayTime() * 2);
-            }
-            if (registers.statusReturnLevelChanged()) {
-                slaveInterface.setSRL(registers.getStatusReturnLevel());
-            }
+        if (f_communication_changed && !slaveInterface.waitingToSendPacket()) {
+            f_communication_changed = false;
+            update_communication(false);
+        }
+
+#if DEBUG_TRACE
+        /* Send at most one record per iteration, only when idle since the
+         * software serial disables interrupts while sending */
+        if (trace.available() > 0 && !slaveInterface.waitingToSendPacket() &&
+                Serial.available() == 0) {
+            uint8_t record[TRACE_RECORD_SIZE];
+            trace.pop(record, TRACE_RECORD_SIZE);
+            debug.write(TRACE_SYNC_BYTE);
+            debug.write(record, TRACE_RECORD_SIZE);
         }
+#endif
 
 #if DEBUG
         static uint32_t led_timer = 0;
         static bool led_state = false;
+        now = millis();
         if (now - led_timer > 500) {
             led_timer = now;
             led_state = !led_state;
@@ -186,9 +444,14 @@ void loop()
         }
 #endif
 
+        /* Sleep until the next interrupt if nothing is due */
+        now = millis();
+        idle_sleep(sensorMgr.idleTime(now));
     }
     slaveInterface.end();
-    sensorMgr.end();
+    if (!f_warm_reset) {
+        sensorMgr.end();
+    }
 
     if (f_reset_requested) {
         registers.resetEEPROM();
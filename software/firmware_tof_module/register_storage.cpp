@@ -1,9 +1,11 @@
 #include "register_storage.h"
 #include "version.h"
+#include "utils.h"
 #include <EEPROM.h>
 
-/* Magic numbers to check if EEPROM was initialized */
-#define MAGIC_ADDR 60
+/* Magic numbers to check if EEPROM was initialized, followed by the version of
+ * the EEPROM layout. They are stored after the register map. */
+#define MAGIC_ADDR (E2END - 4)
 #define MAGIC_DATA_0 35
 #define MAGIC_DATA_1 78
 #define MAGIC_DATA_2 149
@@ -13,10 +15,7 @@
 RegisterStorage::RegisterStorage(uint8_t aRangeErrorCode) :
     mRangeErrorCode(aRangeErrorCode)
 {
-    mIdChanged = false;
-    mBaudrateChanged = false;
-    mReturnDelayTimeChanged = false;
-    mStatusReturnLevelChanged = false;
+    mHooks = nullptr;
 }
 
 void RegisterStorage::init()
@@ -25,20 +24,35 @@ void RegisterStorage::init()
         writeMagic();
         resetEEPROM();
     }
-    for (size_t i = 0; i < EEPROM_AREA_SIZE; i++) {
-        mData[i] = EEPROM.read(i);
-    }
-    for (size_t i = EEPROM_AREA_SIZE; i < REGISTER_SIZE; i++) {
-        mData[i] = 0;
+    for (size_t i = 0; i < REGISTER_SIZE; i++) {
+        if (isPersistent(i)) {
+            mData[i] = EEPROM.read(i);
+        }
+        else {
+            mData[i] = defaultValue(i);
+        }
     }
+    memset(mFrame, 0, FRAME_SIZE);
     mData[REG_MAIN_ENABLED] = mData[REG_AUTO_START];
     mData[REG_AUX_ENABLED] = mData[REG_AUTO_START];
 }
 
 void RegisterStorage::resetEEPROM()
 {
-    for (size_t i = 0; i < EEPROM_AREA_SIZE; i++) {
-        EEPROM.write(i, eeprom_default[i]);
+    for (size_t i = 0; i < REGISTER_SIZE; i++) {
+        if (isPersistent(i)) {
+            EEPROM.write(i, defaultValue(i));
+        }
+    }
+    for (size_t i = 0; i < EEPROM_PAGE_COUNT * PAGE_SIZE; i++) {
+        EEPROM.write(EEPROM_PAGE_ADDR + i, 0);
+    }
+    /* The banks start with the default configuration */
+    for (uint8_t page = 0; page < 2 * PROFILE_COUNT; page++) {
+        size_t page_addr = EEPROM_PAGE_ADDR + (size_t)(EEPROM_PAGE_PROFILE + page) * PAGE_SIZE;
+        for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+            EEPROM.write(page_addr + i, defaultValue(profileRegister(page % 2, i)));
+        }
     }
 }
 
@@ -47,13 +61,29 @@ void RegisterStorage::read(uint8_t address, uint8_t size, uint8_t * data)
     size_t bytes_count = min((size_t)address + (size_t)size, REGISTER_SIZE) - (size_t)address;
 
     for (size_t i = 0; i < bytes_count; i++) {
-        data[i] = mData[address + i];
+        size_t source = address + i;
+        if (source >= REG_INDIRECT_DATA && source < REG_INDIRECT_DATA + INDIRECT_SIZE) {
+            source = indirectSource(source - REG_INDIRECT_DATA);
+            if (source >= REGISTER_SIZE ||
+                    (source >= REG_INDIRECT_DATA && source < REG_INDIRECT_DATA + INDIRECT_SIZE)) {
+                data[i] = 0;
+                continue;
+            }
+        }
+        data[i] = mData[source];
     }
     for (size_t i = bytes_count; i < size; i++) {
         data[i] = 0;
     }
 }
 
+void RegisterStorage::masterRead(uint8_t address, uint8_t size, uint8_t * data)
+{
+    callReadHooks(address, size, false);
+    read(address, size, data);
+    callReadHooks(address, size, true);
+}
+
 uint8_t RegisterStorage::write(uint8_t address, uint8_t size, const uint8_t * data)
 {
     if (mData[REG_LOCK] == 1) {
@@ -64,46 +94,193 @@ uint8_t RegisterStorage::write(uint8_t address, uint8_t size, const uint8_t * da
     uint8_t ret = 0;
 
     for (size_t i = address; i < end_addr; i++) {
-        if (!writable[i] || 
-                data[i - address] < min_range[i] ||
-                data[i - address] > max_range[i]) {
+        if (!accepts(i, data[i - address])) {
             ret = mRangeErrorCode;
             continue;
         }
         mData[i] = data[i - address];
-        if (i < EEPROM_AREA_SIZE) {
+        if (isPersistent(i)) {
             EEPROM.write(i, mData[i]);
-            if (i == REG_ID) {
-                mIdChanged = true;
-            }
-            else if (i == REG_BAUDRATE) {
-                mBaudrateChanged = true;
-            }
-            else if (i == REG_RETURN_DELAY_TIME) {
-                mReturnDelayTimeChanged = true;
-            }
-            else if (i == REG_STATUS_RETURN_LEVEL) {
-                mStatusReturnLevelChanged = true;
-            }
         }
     }
     if (end_addr - address < size) {
         ret = mRangeErrorCode;
     }
-    return ret;
+    /* The valid bytes are committed even if others are rejected, so their
+     * hooks run in any case */
+    return ret | callWriteHooks(address, size, data);
 }
 
 void RegisterStorage::writeRAM(uint8_t address, uint8_t size, const uint8_t * data)
 {
-    if (address < EEPROM_AREA_SIZE) {
+    size_t end_addr = min((size_t)address + (size_t)size, REGISTER_SIZE);
+    for (size_t i = address; i < end_addr; i++) {
+        if (!isPersistent(i) &&
+                data[i - address] >= minRange(i) &&
+                data[i - address] <= maxRange(i)) {
+            mData[i] = data[i - address];
+        }
+    }
+}
+
+void RegisterStorage::readEEPROMPage(uint8_t page, uint8_t offset, uint8_t size, uint8_t * data)
+{
+    size_t page_addr = EEPROM_PAGE_ADDR + (size_t)page * PAGE_SIZE + offset;
+    for (uint8_t i = 0; i < size; i++) {
+        data[i] = EEPROM.read(page_addr + i);
+    }
+}
+
+void RegisterStorage::writeEEPROMPage(uint8_t page, uint8_t offset, uint8_t size, const uint8_t * data)
+{
+    /* Only the modified bytes are written, to save EEPROM cycles and time */
+    size_t page_addr = EEPROM_PAGE_ADDR + (size_t)page * PAGE_SIZE + offset;
+    for (uint8_t i = 0; i < size; i++) {
+        EEPROM.update(page_addr + i, data[i]);
+    }
+}
+
+void RegisterStorage::loadPage(const uint8_t * data, uint8_t size)
+{
+    memset(&mData[REG_PAGE_DATA], 0, PAGE_SIZE);
+    if (size > 0) {
+        memcpy(&mData[REG_PAGE_DATA], data, size);
+    }
+}
+
+void RegisterStorage::loadEEPROMPage(uint8_t page)
+{
+    readEEPROMPage(page, 0, PAGE_SIZE, &mData[REG_PAGE_DATA]);
+}
+
+void RegisterStorage::storeEEPROMPage(uint8_t page)
+{
+    writeEEPROMPage(page, 0, PAGE_SIZE, &mData[REG_PAGE_DATA]);
+}
+
+static size_t profile_address(uint8_t bank, uint8_t sensor)
+{
+    return EEPROM_PAGE_ADDR + (size_t)(EEPROM_PAGE_PROFILE + 2 * (bank - 1) + sensor) * PAGE_SIZE;
+}
+
+void RegisterStorage::loadProfile(uint8_t bank, uint8_t sensor)
+{
+    size_t page_addr = profile_address(bank, sensor);
+    memset(&mData[REG_PAGE_DATA], 0, PAGE_SIZE);
+    for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+        mData[REG_PAGE_DATA + i] = EEPROM.read(page_addr + i);
+    }
+}
+
+uint8_t RegisterStorage::storeProfile(uint8_t bank, uint8_t sensor)
+{
+    const uint8_t *data = &mData[REG_PAGE_DATA];
+    for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+        uint8_t address = profileRegister(sensor, i);
+        if (data[i] < minRange(address) || data[i] > maxRange(address)) {
+            return mRangeErrorCode;
+        }
+    }
+    writeEEPROMPage(EEPROM_PAGE_PROFILE + 2 * (bank - 1) + sensor, 0, PROFILE_SIZE, data);
+    if (mData[REG_PROFILE] == bank) {
+        selectProfile(bank);
+    }
+    return 0;
+}
+
+void RegisterStorage::selectProfile(uint8_t profile)
+{
+    for (uint8_t sensor = 0; sensor < 2; sensor++) {
+        size_t page_addr = profile == 0 ? 0 : profile_address(profile, sensor);
+        for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+            uint8_t address = profileRegister(sensor, i);
+            mData[address] = EEPROM.read(profile == 0 ? address : page_addr + i);
+        }
+    }
+}
+
+void RegisterStorage::writeFrame(uint8_t address, uint8_t size, const uint8_t * data)
+{
+    size_t end_addr = min((size_t)address + (size_t)size, (size_t)REG_FRAME_SEQ + FRAME_SIZE);
+    for (size_t i = max(address, REG_FRAME_SEQ); i < end_addr; i++) {
+        mFrame[i - REG_FRAME_SEQ] = data[i - address];
+    }
+}
+
+void RegisterStorage::publishFrame()
+{
+    mFrame[0] = mData[REG_FRAME_SEQ] == 255 ? 1 : mData[REG_FRAME_SEQ] + 1;
+    memcpy(&mData[REG_FRAME_SEQ], mFrame, FRAME_SIZE);
+}
+
+void RegisterStorage::callReadHooks(uint8_t address, uint8_t size, bool finish)
+{
+    if (mHooks == nullptr) {
         return;
     }
     size_t end_addr = min((size_t)address + (size_t)size, REGISTER_SIZE);
+    uint8_t previous = HOOK_NONE;
     for (size_t i = address; i < end_addr; i++) {
-        if (data[i - address] >= min_range[i] && data[i - address] <= max_range[i]) {
-            mData[i] = data[i - address];
+        uint8_t id = hookOf(i);
+        uint8_t hook_address = address;
+        uint8_t hook_size = size;
+        if (i >= REG_INDIRECT_DATA && i < REG_INDIRECT_DATA + INDIRECT_SIZE) {
+            /* The registers read through the indirect window are hooked as
+             * single-byte reads */
+            hook_address = indirectSource(i - REG_INDIRECT_DATA);
+            hook_size = 1;
+            id = hook_address < REGISTER_SIZE ? hookOf(hook_address) : HOOK_NONE;
+        }
+        else if (id == previous) {
+            continue;
+        }
+        previous = id;
+        if (id == HOOK_NONE) {
+            continue;
+        }
+        HookHandlers handlers;
+        memcpy_P(&handlers, &mHooks[id], sizeof(HookHandlers));
+        void (*handler)(uint8_t, uint8_t) = finish ? handlers.finishRead : handlers.prepareRead;
+        if (handler != nullptr) {
+            handler(hook_address, hook_size);
+        }
+    }
+}
+
+bool RegisterStorage::accepts(size_t address, uint8_t value)
+{
+    return isWritable(address) &&
+        value >= minRange(address) &&
+        value <= maxRange(address) &&
+        (address != REG_BAUDRATE || baudrate_accurate(value));
+}
+
+uint8_t RegisterStorage::callWriteHooks(uint8_t address, uint8_t size, const uint8_t * data)
+{
+    if (mHooks == nullptr) {
+        return 0;
+    }
+    size_t end_addr = min((size_t)address + (size_t)size, REGISTER_SIZE);
+    uint8_t previous = HOOK_NONE;
+    uint8_t ret = 0;
+    for (size_t i = address; i < end_addr; i++) {
+        if (!accepts(i, data[i - address])) {
+            /* Rejected byte, the register was not modified */
+            continue;
+        }
+        uint8_t id = hookOf(i);
+        if (id == previous || id == HOOK_NONE) {
+            previous = id;
+            continue;
+        }
+        previous = id;
+        HookHandlers handlers;
+        memcpy_P(&handlers, &mHooks[id], sizeof(HookHandlers));
+        if (handlers.written != nullptr) {
+            ret |= handlers.written(address, size);
         }
     }
+    return ret;
 }
 
 bool RegisterStorage::checkMagic()
@@ -111,7 +288,8 @@ bool RegisterStorage::checkMagic()
     return EEPROM.read(MAGIC_ADDR) == MAGIC_DATA_0 &&
         EEPROM.read(MAGIC_ADDR + 1) == MAGIC_DATA_1 &&
         EEPROM.read(MAGIC_ADDR + 2) == MAGIC_DATA_2 &&
-        EEPROM.read(MAGIC_ADDR + 3) == MAGIC_DATA_3;
+        EEPROM.read(MAGIC_ADDR + 3) == MAGIC_DATA_3 &&
+        EEPROM.read(MAGIC_ADDR + 4) == EEPROM_LAYOUT_VERSION;
 }
 
 void RegisterStorage::writeMagic()
@@ -120,10 +298,11 @@ void RegisterStorage::writeMagic()
     EEPROM.write(MAGIC_ADDR + 1, MAGIC_DATA_1);
     EEPROM.write(MAGIC_ADDR + 2, MAGIC_DATA_2);
     EEPROM.write(MAGIC_ADDR + 3, MAGIC_DATA_3);
+    EEPROM.write(MAGIC_ADDR + 4, EEPROM_LAYOUT_VERSION);
 }
 
 
-bool RegisterStorage::writable[REGISTER_SIZE] = {
+const bool RegisterStorage::writable[REGISTER_SIZE] PROGMEM = {
     /* EEPROM area */
     false, // REG_MODEL_NUMBER = 0x00
     false,
@@ -186,139 +365,1176 @@ bool RegisterStorage::writable[REGISTER_SIZE] = {
 
     false, // REG_INPUT_VOLTAGE = 0x31
     true, // REG_LOCK = 0x32
-};
 
-uint8_t RegisterStorage::min_range[REGISTER_SIZE] = {
-    /* EEPROM area */
-    0, // REG_MODEL_NUMBER = 0x00
-    0,
-    0, // REG_FIRMWARE_VERSION = 0x02
+    /* Adaptive period, EEPROM */
+    true, // REG_MAIN_ADAPTIVE_PERIOD = 0x33
+    true, // REG_MAIN_MIN_PERIOD = 0x34
+    true,
+    true, // REG_MAIN_MAX_PERIOD = 0x36
+    true,
 
-    0, // REG_ID = 0x03
-    1, // REG_BAUDRATE = 0x04
-    0, // REG_RETURN_DELAY_TIME = 0x05
-    0, // REG_STATUS_RETURN_LEVEL = 0x06
+    true, // REG_AUX_ADAPTIVE_PERIOD = 0x38
+    true, // REG_AUX_MIN_PERIOD = 0x39
+    true,
+    true, // REG_AUX_MAX_PERIOD = 0x3B
+    true,
 
-    4, // REG_MAIN_MIN_RANGE = 0x07
-    0,
-    4, // REG_MAIN_MAX_RANGE = 0x09
-    0,
-    0, // REG_MAIN_QUALITY_THRESHOLD = 0x0B
-    0,
-    0, // REG_MAIN_PERIOD = 0x0D
-    0,
-    0,
-    0,
+    /* Adaptive period, RAM */
+    false, // REG_MAIN_CURRENT_PERIOD = 0x3D
+    false,
+    false, // REG_MAIN_RANGE_RATE = 0x3F
+    false,
 
-    4, // REG_AUX_MIN_RANGE = 0x11
-    0,
-    4, // REG_AUX_MAX_RANGE = 0x13
-    0,
-    0, // REG_AUX_QUALITY_THRESHOLD = 0x15
-    0,
-    0, // REG_AUX_PERIOD = 0x17
-    0,
-    0,
-    0,
+    false, // REG_AUX_CURRENT_PERIOD = 0x41
+    false,
+    false, // REG_AUX_RANGE_RATE = 0x43
+    false,
 
-    0, // REG_AUTO_START = 0x1B
-    0, // REG_MAIN_POLLING = 0x1C
-    0, // REG_AUX_POLLING = 0x1D
+    /* Interleaved mode, EEPROM */
+    true, // REG_INTERLEAVED_MODE = 0x45
+    true, // REG_MAIN_OFFSET = 0x46
+    true,
+    true, // REG_AUX_OFFSET = 0x48
+    true,
 
-    0, // Reserved (0x1E - 0x1F)
-    0,
+    /* Interleaved mode, RAM */
+    false, // REG_MERGED_MCSLR = 0x4A
+    false, // REG_MERGED_RANGE = 0x4B
+    false,
+    false, // REG_MERGED_TIMESTAMP = 0x4D
+    false,
+    false, // REG_MERGED_SOURCE = 0x4F
 
-    /* RAM area */
-    0, // REG_MAIN_ENABLED = 0x20
-    0, // REG_AUX_ENABLED = 0x21
-    0, // REG_WIRING_STATUS = 0x22
+    /* Fault recovery, RAM */
+    false, // REG_MAIN_RECOVERY_COUNT = 0x50
+    false, // REG_AUX_RECOVERY_COUNT = 0x51
 
-    0, // REG_MAIN_MCSLR = 0x23
-    0, // REG_MAIN_RANGE = 0x24
-    0,
-    0, // REG_MAIN_RAW_RANGE = 0x26
-    0,
-    0, // REG_MAIN_QUALITY = 0x28
-    0,
+    /* Soft reset, EEPROM */
+    true, // REG_WARM_RESET = 0x52
 
-    0, // REG_AUX_MCSLR = 0x2A
-    0, // REG_AUX_RANGE = 0x2B
-    0,
-    0, // REG_AUX_RAW_RANGE = 0x2D
-    0,
-    0, // REG_AUX_QUALITY = 0x2F
-    0,
+    /* Trace, RAM */
+    false, // REG_TRACE_COUNT = 0x53
+    false, // REG_TRACE_DATA = 0x54
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
 
-    0, // REG_INPUT_VOLTAGE = 0x31
-    0, // REG_LOCK = 0x32
-};
+    /* Statistics, EEPROM */
+    true, // REG_STATS_WINDOW = 0x64
+    true,
+    true, // REG_STATS_BIN_WIDTH = 0x66
+    true,
 
-uint8_t RegisterStorage::max_range[REGISTER_SIZE] = {
-    /* EEPROM area */
-    255, // REG_MODEL_NUMBER = 0x00
-    255,
-    255, // REG_FIRMWARE_VERSION = 0x02
+    /* Statistics, RAM */
+    true, // REG_STATS_RESET = 0x68
 
-    253, // REG_ID = 0x03
-    207, // REG_BAUDRATE = 0x04
-    254, // REG_RETURN_DELAY_TIME = 0x05
-    2, // REG_STATUS_RETURN_LEVEL = 0x06
+    /* Page window, RAM */
+    true, // REG_PAGE_SELECT = 0x69
+    true, // REG_PAGE_DATA = 0x6A
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
 
-    255, // REG_MAIN_MIN_RANGE = 0x07
-    255,
-    255, // REG_MAIN_MAX_RANGE = 0x09
-    255,
-    255, // REG_MAIN_QUALITY_THRESHOLD = 0x0B
-    255,
-    255, // REG_MAIN_PERIOD = 0x0D
-    255,
-    255,
-    255,
+    /* Calibration, EEPROM */
+    true, // REG_MAIN_CAL_OFFSET = 0x8A
+    true,
+    true, // REG_MAIN_CAL_GAIN = 0x8C
+    true,
+    true, // REG_AUX_CAL_OFFSET = 0x8E
+    true,
+    true, // REG_AUX_CAL_GAIN = 0x90
+    true,
 
-    255, // REG_AUX_MIN_RANGE = 0x11
-    255,
-    255, // REG_AUX_MAX_RANGE = 0x13
-    255,
-    255, // REG_AUX_QUALITY_THRESHOLD = 0x15
-    255,
-    255, // REG_AUX_PERIOD = 0x17
-    255,
-    255,
-    255,
+    /* Measurement frame, RAM */
+    false, // REG_FRAME_SEQ = 0x92
+    false, // REG_FRAME_UPDATED = 0x93
+    false, // REG_FRAME_MAIN_RANGE = 0x94
+    false,
+    false, // REG_FRAME_AUX_RANGE = 0x96
+    false,
+    false, // REG_FRAME_TIMESTAMP = 0x98
+    false,
 
-    1, // REG_AUTO_START = 0x1B
-    1, // REG_MAIN_POLLING = 0x1C
-    1, // REG_AUX_POLLING = 0x1D
+    /* Communication, RAM */
+    false, // REG_REAL_BAUDRATE = 0x9A
+    false,
+    false,
+    false,
 
-    255, // Reserved (0x1E - 0x1F)
-    255,
+    /* Outlier rejection, EEPROM */
+    true, // REG_OUTLIER_GATE = 0x9E
+    true,
+    true, // REG_OUTLIER_CONFIRM = 0xA0
 
-    /* RAM area */
-    1, // REG_MAIN_ENABLED = 0x20
-    1, // REG_AUX_ENABLED = 0x21
-    3, // REG_WIRING_STATUS = 0x22
+    /* Outlier rejection, RAM */
+    false, // REG_MAIN_VALIDITY = 0xA1
+    false, // REG_AUX_VALIDITY = 0xA2
+    false, // REG_MAIN_REJECT_COUNT = 0xA3
+    false,
+    false, // REG_AUX_REJECT_COUNT = 0xA5
+    false,
 
-    254, // REG_MAIN_MCSLR = 0x23
+    /* Idle sleep, EEPROM */
+    true, // REG_IDLE_SLEEP = 0xA7
+
+    /* Idle sleep, RAM */
+    false, // REG_WAKEUP_COUNT = 0xA8
+    false,
+    false,
+    false,
+    false, // REG_SLEEP_TIME = 0xAC
+    false,
+    false,
+    false,
+
+    /* Indirect access, EEPROM */
+    true, // REG_INDIRECT_ADDRESS = 0xB0
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+
+    /* Indirect access, RAM */
+    false, // REG_INDIRECT_DATA = 0xC0
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+
+    /* Timing budget, EEPROM */
+    true, // REG_MAIN_TIMING_BUDGET = 0xD0
+    true, // REG_MAIN_DISTANCE_MODE = 0xD1
+    true, // REG_AUX_TIMING_BUDGET = 0xD2
+    true, // REG_AUX_DISTANCE_MODE = 0xD3
+
+    /* Timing budget, RAM */
+    false, // REG_MAIN_MEASURE_RATE = 0xD4
+    false,
+    false, // REG_AUX_MEASURE_RATE = 0xD6
+    false,
+
+    /* External trigger, EEPROM */
+    true, // REG_EXTERNAL_TRIGGER = 0xD8
+    true, // REG_TRIGGER_DELAY = 0xD9
+
+    /* External trigger, RAM */
+    true, // REG_TRIGGER = 0xDA
+
+    /* Clock synchronization, RAM */
+    true, // REG_SYNC_TIME = 0xDB
+    true,
+    true,
+    true,
+    false, // REG_SYNC_ERROR = 0xDF
+    false,
+    false, // REG_SYNC_DRIFT = 0xE1
+    false,
+    false, // REG_SYNC_COUNT = 0xE3
+
+    /* Profiles, RAM */
+    true, // REG_PROFILE = 0xE4
+
+    /* Conditional read, EEPROM */
+    true, // REG_NEW_DATA_SOURCES = 0xE5
+
+    /* Time to contact, EEPROM */
+    true, // REG_COLLISION_ALARM = 0xE6
+    true,
+
+    /* Time to contact, RAM */
+    false, // REG_MAIN_TIME_TO_CONTACT = 0xE8
+    false,
+    false, // REG_AUX_TIME_TO_CONTACT = 0xEA
+    false,
+};
+
+const bool RegisterStorage::persistent[REGISTER_SIZE] PROGMEM = {
+    /* EEPROM area */
+    true, // REG_MODEL_NUMBER = 0x00
+    true,
+    true, // REG_FIRMWARE_VERSION = 0x02
+
+    true, // REG_ID = 0x03
+    true, // REG_BAUDRATE = 0x04
+    true, // REG_RETURN_DELAY_TIME = 0x05
+    true, // REG_STATUS_RETURN_LEVEL = 0x06
+
+    true, // REG_MAIN_MIN_RANGE = 0x07
+    true,
+    true, // REG_MAIN_MAX_RANGE = 0x09
+    true,
+    true, // REG_MAIN_QUALITY_THRESHOLD = 0x0B
+    true,
+    true, // REG_MAIN_PERIOD = 0x0D
+    true,
+    true,
+    true,
+
+    true, // REG_AUX_MIN_RANGE = 0x11
+    true,
+    true, // REG_AUX_MAX_RANGE = 0x13
+    true,
+    true, // REG_AUX_QUALITY_THRESHOLD = 0x15
+    true,
+    true, // REG_AUX_PERIOD = 0x17
+    true,
+    true,
+    true,
+
+    true, // REG_AUTO_START = 0x1B
+    true, // REG_MAIN_POLLING = 0x1C
+    true, // REG_AUX_POLLING = 0x1D
+
+    true, // Reserved (0x1E - 0x1F)
+    true,
+
+    /* RAM area */
+    false, // REG_MAIN_ENABLED = 0x20
+    false, // REG_AUX_ENABLED = 0x21
+    false, // REG_WIRING_STATUS = 0x22
+
+    false, // REG_MAIN_MCSLR = 0x23
+    false, // REG_MAIN_RANGE = 0x24
+    false,
+    false, // REG_MAIN_RAW_RANGE = 0x26
+    false,
+    false, // REG_MAIN_QUALITY = 0x28
+    false,
+
+    false, // REG_AUX_MCSLR = 0x2A
+    false, // REG_AUX_RANGE = 0x2B
+    false,
+    false, // REG_AUX_RAW_RANGE = 0x2D
+    false,
+    false, // REG_AUX_QUALITY = 0x2F
+    false,
+
+    false, // REG_INPUT_VOLTAGE = 0x31
+    false, // REG_LOCK = 0x32
+
+    /* Adaptive period, EEPROM */
+    true, // REG_MAIN_ADAPTIVE_PERIOD = 0x33
+    true, // REG_MAIN_MIN_PERIOD = 0x34
+    true,
+    true, // REG_MAIN_MAX_PERIOD = 0x36
+    true,
+
+    true, // REG_AUX_ADAPTIVE_PERIOD = 0x38
+    true, // REG_AUX_MIN_PERIOD = 0x39
+    true,
+    true, // REG_AUX_MAX_PERIOD = 0x3B
+    true,
+
+    /* Adaptive period, RAM */
+    false, // REG_MAIN_CURRENT_PERIOD = 0x3D
+    false,
+    false, // REG_MAIN_RANGE_RATE = 0x3F
+    false,
+
+    false, // REG_AUX_CURRENT_PERIOD = 0x41
+    false,
+    false, // REG_AUX_RANGE_RATE = 0x43
+    false,
+
+    /* Interleaved mode, EEPROM */
+    true, // REG_INTERLEAVED_MODE = 0x45
+    true, // REG_MAIN_OFFSET = 0x46
+    true,
+    true, // REG_AUX_OFFSET = 0x48
+    true,
+
+    /* Interleaved mode, RAM */
+    false, // REG_MERGED_MCSLR = 0x4A
+    false, // REG_MERGED_RANGE = 0x4B
+    false,
+    false, // REG_MERGED_TIMESTAMP = 0x4D
+    false,
+    false, // REG_MERGED_SOURCE = 0x4F
+
+    /* Fault recovery, RAM */
+    false, // REG_MAIN_RECOVERY_COUNT = 0x50
+    false, // REG_AUX_RECOVERY_COUNT = 0x51
+
+    /* Soft reset, EEPROM */
+    true, // REG_WARM_RESET = 0x52
+
+    /* Trace, RAM */
+    false, // REG_TRACE_COUNT = 0x53
+    false, // REG_TRACE_DATA = 0x54
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+
+    /* Statistics, EEPROM */
+    true, // REG_STATS_WINDOW = 0x64
+    true,
+    true, // REG_STATS_BIN_WIDTH = 0x66
+    true,
+
+    /* Statistics, RAM */
+    false, // REG_STATS_RESET = 0x68
+
+    /* Page window, RAM */
+    false, // REG_PAGE_SELECT = 0x69
+    false, // REG_PAGE_DATA = 0x6A
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+
+    /* Calibration, EEPROM */
+    true, // REG_MAIN_CAL_OFFSET = 0x8A
+    true,
+    true, // REG_MAIN_CAL_GAIN = 0x8C
+    true,
+    true, // REG_AUX_CAL_OFFSET = 0x8E
+    true,
+    true, // REG_AUX_CAL_GAIN = 0x90
+    true,
+
+    /* Measurement frame, RAM */
+    false, // REG_FRAME_SEQ = 0x92
+    false, // REG_FRAME_UPDATED = 0x93
+    false, // REG_FRAME_MAIN_RANGE = 0x94
+    false,
+    false, // REG_FRAME_AUX_RANGE = 0x96
+    false,
+    false, // REG_FRAME_TIMESTAMP = 0x98
+    false,
+
+    /* Communication, RAM */
+    false, // REG_REAL_BAUDRATE = 0x9A
+    false,
+    false,
+    false,
+
+    /* Outlier rejection, EEPROM */
+    true, // REG_OUTLIER_GATE = 0x9E
+    true,
+    true, // REG_OUTLIER_CONFIRM = 0xA0
+
+    /* Outlier rejection, RAM */
+    false, // REG_MAIN_VALIDITY = 0xA1
+    false, // REG_AUX_VALIDITY = 0xA2
+    false, // REG_MAIN_REJECT_COUNT = 0xA3
+    false,
+    false, // REG_AUX_REJECT_COUNT = 0xA5
+    false,
+
+    /* Idle sleep, EEPROM */
+    true, // REG_IDLE_SLEEP = 0xA7
+
+    /* Idle sleep, RAM */
+    false, // REG_WAKEUP_COUNT = 0xA8
+    false,
+    false,
+    false,
+    false, // REG_SLEEP_TIME = 0xAC
+    false,
+    false,
+    false,
+
+    /* Indirect access, EEPROM */
+    true, // REG_INDIRECT_ADDRESS = 0xB0
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+    true,
+
+    /* Indirect access, RAM */
+    false, // REG_INDIRECT_DATA = 0xC0
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+    false,
+
+    /* Timing budget, EEPROM */
+    true, // REG_MAIN_TIMING_BUDGET = 0xD0
+    true, // REG_MAIN_DISTANCE_MODE = 0xD1
+    true, // REG_AUX_TIMING_BUDGET = 0xD2
+    true, // REG_AUX_DISTANCE_MODE = 0xD3
+
+    /* Timing budget, RAM */
+    false, // REG_MAIN_MEASURE_RATE = 0xD4
+    false,
+    false, // REG_AUX_MEASURE_RATE = 0xD6
+    false,
+
+    /* External trigger, EEPROM */
+    true, // REG_EXTERNAL_TRIGGER = 0xD8
+    true, // REG_TRIGGER_DELAY = 0xD9
+
+    /* External trigger, RAM */
+    false, // REG_TRIGGER = 0xDA
+
+    /* Clock synchronization, RAM */
+    false, // REG_SYNC_TIME = 0xDB
+    false,
+    false,
+    false,
+    false, // REG_SYNC_ERROR = 0xDF
+    false,
+    false, // REG_SYNC_DRIFT = 0xE1
+    false,
+    false, // REG_SYNC_COUNT = 0xE3
+
+    /* Profiles, RAM */
+    false, // REG_PROFILE = 0xE4
+
+    /* Conditional read, EEPROM */
+    true, // REG_NEW_DATA_SOURCES = 0xE5
+
+    /* Time to contact, EEPROM */
+    true, // REG_COLLISION_ALARM = 0xE6
+    true,
+
+    /* Time to contact, RAM */
+    false, // REG_MAIN_TIME_TO_CONTACT = 0xE8
+    false,
+    false, // REG_AUX_TIME_TO_CONTACT = 0xEA
+    false,
+};
+
+const uint8_t RegisterStorage::min_range[REGISTER_SIZE] PROGMEM = {
+    /* EEPROM area */
+    0, // REG_MODEL_NUMBER = 0x00
+    0,
+    0, // REG_FIRMWARE_VERSION = 0x02
+
+    0, // REG_ID = 0x03
+    1, // REG_BAUDRATE = 0x04
+    0, // REG_RETURN_DELAY_TIME = 0x05
+    0, // REG_STATUS_RETURN_LEVEL = 0x06
+
+    4, // REG_MAIN_MIN_RANGE = 0x07
+    0,
+    4, // REG_MAIN_MAX_RANGE = 0x09
+    0,
+    0, // REG_MAIN_QUALITY_THRESHOLD = 0x0B
+    0,
+    0, // REG_MAIN_PERIOD = 0x0D
+    0,
+    0,
+    0,
+
+    4, // REG_AUX_MIN_RANGE = 0x11
+    0,
+    4, // REG_AUX_MAX_RANGE = 0x13
+    0,
+    0, // REG_AUX_QUALITY_THRESHOLD = 0x15
+    0,
+    0, // REG_AUX_PERIOD = 0x17
+    0,
+    0,
+    0,
+
+    0, // REG_AUTO_START = 0x1B
+    0, // REG_MAIN_POLLING = 0x1C
+    0, // REG_AUX_POLLING = 0x1D
+
+    0, // Reserved (0x1E - 0x1F)
+    0,
+
+    /* RAM area */
+    0, // REG_MAIN_ENABLED = 0x20
+    0, // REG_AUX_ENABLED = 0x21
+    0, // REG_WIRING_STATUS = 0x22
+
+    0, // REG_MAIN_MCSLR = 0x23
+    0, // REG_MAIN_RANGE = 0x24
+    0,
+    0, // REG_MAIN_RAW_RANGE = 0x26
+    0,
+    0, // REG_MAIN_QUALITY = 0x28
+    0,
+
+    0, // REG_AUX_MCSLR = 0x2A
+    0, // REG_AUX_RANGE = 0x2B
+    0,
+    0, // REG_AUX_RAW_RANGE = 0x2D
+    0,
+    0, // REG_AUX_QUALITY = 0x2F
+    0,
+
+    0, // REG_INPUT_VOLTAGE = 0x31
+    0, // REG_LOCK = 0x32
+
+    /* Adaptive period, EEPROM */
+    0, // REG_MAIN_ADAPTIVE_PERIOD = 0x33
+    0, // REG_MAIN_MIN_PERIOD = 0x34
+    0,
+    0, // REG_MAIN_MAX_PERIOD = 0x36
+    0,
+
+    0, // REG_AUX_ADAPTIVE_PERIOD = 0x38
+    0, // REG_AUX_MIN_PERIOD = 0x39
+    0,
+    0, // REG_AUX_MAX_PERIOD = 0x3B
+    0,
+
+    /* Adaptive period, RAM */
+    0, // REG_MAIN_CURRENT_PERIOD = 0x3D
+    0,
+    0, // REG_MAIN_RANGE_RATE = 0x3F
+    0,
+
+    0, // REG_AUX_CURRENT_PERIOD = 0x41
+    0,
+    0, // REG_AUX_RANGE_RATE = 0x43
+    0,
+
+    /* Interleaved mode, EEPROM */
+    0, // REG_INTERLEAVED_MODE = 0x45
+    0, // REG_MAIN_OFFSET = 0x46
+    0,
+    0, // REG_AUX_OFFSET = 0x48
+    0,
+
+    /* Interleaved mode, RAM */
+    0, // REG_MERGED_MCSLR = 0x4A
+    0, // REG_MERGED_RANGE = 0x4B
+    0,
+    0, // REG_MERGED_TIMESTAMP = 0x4D
+    0,
+    0, // REG_MERGED_SOURCE = 0x4F
+
+    /* Fault recovery, RAM */
+    0, // REG_MAIN_RECOVERY_COUNT = 0x50
+    0, // REG_AUX_RECOVERY_COUNT = 0x51
+
+    /* Soft reset, EEPROM */
+    0, // REG_WARM_RESET = 0x52
+
+    /* Trace, RAM */
+    0, // REG_TRACE_COUNT = 0x53
+    0, // REG_TRACE_DATA = 0x54
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Statistics, EEPROM */
+    0, // REG_STATS_WINDOW = 0x64
+    0,
+    0, // REG_STATS_BIN_WIDTH = 0x66
+    0,
+
+    /* Statistics, RAM */
+    0, // REG_STATS_RESET = 0x68
+
+    /* Page window, RAM */
+    0, // REG_PAGE_SELECT = 0x69
+    0, // REG_PAGE_DATA = 0x6A
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Calibration, EEPROM */
+    0, // REG_MAIN_CAL_OFFSET = 0x8A
+    0,
+    0, // REG_MAIN_CAL_GAIN = 0x8C
+    0,
+    0, // REG_AUX_CAL_OFFSET = 0x8E
+    0,
+    0, // REG_AUX_CAL_GAIN = 0x90
+    0,
+
+    /* Measurement frame, RAM */
+    0, // REG_FRAME_SEQ = 0x92
+    0, // REG_FRAME_UPDATED = 0x93
+    0, // REG_FRAME_MAIN_RANGE = 0x94
+    0,
+    0, // REG_FRAME_AUX_RANGE = 0x96
+    0,
+    0, // REG_FRAME_TIMESTAMP = 0x98
+    0,
+
+    /* Communication, RAM */
+    0, // REG_REAL_BAUDRATE = 0x9A
+    0,
+    0,
+    0,
+
+    /* Outlier rejection, EEPROM */
+    0, // REG_OUTLIER_GATE = 0x9E
+    0,
+    1, // REG_OUTLIER_CONFIRM = 0xA0
+
+    /* Outlier rejection, RAM */
+    0, // REG_MAIN_VALIDITY = 0xA1
+    0, // REG_AUX_VALIDITY = 0xA2
+    0, // REG_MAIN_REJECT_COUNT = 0xA3
+    0,
+    0, // REG_AUX_REJECT_COUNT = 0xA5
+    0,
+
+    /* Idle sleep, EEPROM */
+    0, // REG_IDLE_SLEEP = 0xA7
+
+    /* Idle sleep, RAM */
+    0, // REG_WAKEUP_COUNT = 0xA8
+    0,
+    0,
+    0,
+    0, // REG_SLEEP_TIME = 0xAC
+    0,
+    0,
+    0,
+
+    /* Indirect access, EEPROM */
+    0, // REG_INDIRECT_ADDRESS = 0xB0
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Indirect access, RAM */
+    0, // REG_INDIRECT_DATA = 0xC0
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Timing budget, EEPROM */
+    20, // REG_MAIN_TIMING_BUDGET = 0xD0
+    0, // REG_MAIN_DISTANCE_MODE = 0xD1
+    20, // REG_AUX_TIMING_BUDGET = 0xD2
+    0, // REG_AUX_DISTANCE_MODE = 0xD3
+
+    /* Timing budget, RAM */
+    0, // REG_MAIN_MEASURE_RATE = 0xD4
+    0,
+    0, // REG_AUX_MEASURE_RATE = 0xD6
+    0,
+
+    /* External trigger, EEPROM */
+    0, // REG_EXTERNAL_TRIGGER = 0xD8
+    0, // REG_TRIGGER_DELAY = 0xD9
+
+    /* External trigger, RAM */
+    0, // REG_TRIGGER = 0xDA
+
+    /* Clock synchronization, RAM */
+    0, // REG_SYNC_TIME = 0xDB
+    0,
+    0,
+    0,
+    0, // REG_SYNC_ERROR = 0xDF
+    0,
+    0, // REG_SYNC_DRIFT = 0xE1
+    0,
+    0, // REG_SYNC_COUNT = 0xE3
+
+    /* Profiles, RAM */
+    0, // REG_PROFILE = 0xE4
+
+    /* Conditional read, EEPROM */
+    0, // REG_NEW_DATA_SOURCES = 0xE5
+
+    /* Time to contact, EEPROM */
+    0, // REG_COLLISION_ALARM = 0xE6
+    0,
+
+    /* Time to contact, RAM */
+    0, // REG_MAIN_TIME_TO_CONTACT = 0xE8
+    0,
+    0, // REG_AUX_TIME_TO_CONTACT = 0xEA
+    0,
+};
+
+const uint8_t RegisterStorage::max_range[REGISTER_SIZE] PROGMEM = {
+    /* EEPROM area */
+    255, // REG_MODEL_NUMBER = 0x00
+    255,
+    255, // REG_FIRMWARE_VERSION = 0x02
+
+    253, // REG_ID = 0x03
+    BAUDRATE_MAX_VALUE, // REG_BAUDRATE = 0x04
+    254, // REG_RETURN_DELAY_TIME = 0x05
+    2, // REG_STATUS_RETURN_LEVEL = 0x06
+
+    255, // REG_MAIN_MIN_RANGE = 0x07
+    255,
+    255, // REG_MAIN_MAX_RANGE = 0x09
+    255,
+    255, // REG_MAIN_QUALITY_THRESHOLD = 0x0B
+    255,
+    255, // REG_MAIN_PERIOD = 0x0D
+    255,
+    255,
+    255,
+
+    255, // REG_AUX_MIN_RANGE = 0x11
+    255,
+    255, // REG_AUX_MAX_RANGE = 0x13
+    255,
+    255, // REG_AUX_QUALITY_THRESHOLD = 0x15
+    255,
+    255, // REG_AUX_PERIOD = 0x17
+    255,
+    255,
+    255,
+
+    1, // REG_AUTO_START = 0x1B
+    1, // REG_MAIN_POLLING = 0x1C
+    1, // REG_AUX_POLLING = 0x1D
+
+    255, // Reserved (0x1E - 0x1F)
+    255,
+
+    /* RAM area */
+    1, // REG_MAIN_ENABLED = 0x20
+    1, // REG_AUX_ENABLED = 0x21
+    3, // REG_WIRING_STATUS = 0x22
+
+    254, // REG_MAIN_MCSLR = 0x23
     255, // REG_MAIN_RANGE = 0x24
     255,
-    255, // REG_MAIN_RAW_RANGE = 0x26
+    255, // REG_MAIN_RAW_RANGE = 0x26
+    255,
+    255, // REG_MAIN_QUALITY = 0x28
+    255,
+
+    254, // REG_AUX_MCSLR = 0x2A
+    255, // REG_AUX_RANGE = 0x2B
+    255,
+    255, // REG_AUX_RAW_RANGE = 0x2D
+    255,
+    255, // REG_AUX_QUALITY = 0x2F
+    255,
+
+    175, // REG_INPUT_VOLTAGE = 0x31
+    1, // REG_LOCK = 0x32
+
+    /* Adaptive period, EEPROM */
+    1, // REG_MAIN_ADAPTIVE_PERIOD = 0x33
+    255, // REG_MAIN_MIN_PERIOD = 0x34
+    255,
+    255, // REG_MAIN_MAX_PERIOD = 0x36
+    255,
+
+    1, // REG_AUX_ADAPTIVE_PERIOD = 0x38
+    255, // REG_AUX_MIN_PERIOD = 0x39
+    255,
+    255, // REG_AUX_MAX_PERIOD = 0x3B
+    255,
+
+    /* Adaptive period, RAM */
+    255, // REG_MAIN_CURRENT_PERIOD = 0x3D
+    255,
+    255, // REG_MAIN_RANGE_RATE = 0x3F
+    255,
+
+    255, // REG_AUX_CURRENT_PERIOD = 0x41
+    255,
+    255, // REG_AUX_RANGE_RATE = 0x43
+    255,
+
+    /* Interleaved mode, EEPROM */
+    2, // REG_INTERLEAVED_MODE = 0x45
+    255, // REG_MAIN_OFFSET = 0x46
+    255,
+    255, // REG_AUX_OFFSET = 0x48
+    255,
+
+    /* Interleaved mode, RAM */
+    254, // REG_MERGED_MCSLR = 0x4A
+    255, // REG_MERGED_RANGE = 0x4B
+    255,
+    255, // REG_MERGED_TIMESTAMP = 0x4D
+    255,
+    1, // REG_MERGED_SOURCE = 0x4F
+
+    /* Fault recovery, RAM */
+    255, // REG_MAIN_RECOVERY_COUNT = 0x50
+    255, // REG_AUX_RECOVERY_COUNT = 0x51
+
+    /* Soft reset, EEPROM */
+    1, // REG_WARM_RESET = 0x52
+
+    /* Trace, RAM */
+    255, // REG_TRACE_COUNT = 0x53
+    255, // REG_TRACE_DATA = 0x54
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+
+    /* Statistics, EEPROM */
+    255, // REG_STATS_WINDOW = 0x64
+    255,
+    255, // REG_STATS_BIN_WIDTH = 0x66
+    255,
+
+    /* Statistics, RAM */
+    3, // REG_STATS_RESET = 0x68
+
+    /* Page window, RAM */
+    PAGE_COUNT - 1, // REG_PAGE_SELECT = 0x69
+    255, // REG_PAGE_DATA = 0x6A
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+
+    /* Calibration, EEPROM */
+    255, // REG_MAIN_CAL_OFFSET = 0x8A
+    255,
+    255, // REG_MAIN_CAL_GAIN = 0x8C
+    255,
+    255, // REG_AUX_CAL_OFFSET = 0x8E
+    255,
+    255, // REG_AUX_CAL_GAIN = 0x90
+    255,
+
+    /* Measurement frame, RAM */
+    255, // REG_FRAME_SEQ = 0x92
+    255, // REG_FRAME_UPDATED = 0x93
+    255, // REG_FRAME_MAIN_RANGE = 0x94
+    255,
+    255, // REG_FRAME_AUX_RANGE = 0x96
+    255,
+    255, // REG_FRAME_TIMESTAMP = 0x98
+    255,
+
+    /* Communication, RAM */
+    255, // REG_REAL_BAUDRATE = 0x9A
+    255,
+    255,
+    255,
+
+    /* Outlier rejection, EEPROM */
+    255, // REG_OUTLIER_GATE = 0x9E
+    255,
+    255, // REG_OUTLIER_CONFIRM = 0xA0
+
+    /* Outlier rejection, RAM */
+    255, // REG_MAIN_VALIDITY = 0xA1
+    255, // REG_AUX_VALIDITY = 0xA2
+    255, // REG_MAIN_REJECT_COUNT = 0xA3
+    255,
+    255, // REG_AUX_REJECT_COUNT = 0xA5
+    255,
+
+    /* Idle sleep, EEPROM */
+    1, // REG_IDLE_SLEEP = 0xA7
+
+    /* Idle sleep, RAM */
+    255, // REG_WAKEUP_COUNT = 0xA8
+    255,
+    255,
+    255,
+    255, // REG_SLEEP_TIME = 0xAC
+    255,
+    255,
+    255,
+
+    /* Indirect access, EEPROM */
+    255, // REG_INDIRECT_ADDRESS = 0xB0
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
     255,
-    255, // REG_MAIN_QUALITY = 0x28
     255,
 
-    254, // REG_AUX_MCSLR = 0x2A
-    255, // REG_AUX_RANGE = 0x2B
+    /* Indirect access, RAM */
+    255, // REG_INDIRECT_DATA = 0xC0
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
     255,
-    255, // REG_AUX_RAW_RANGE = 0x2D
     255,
-    255, // REG_AUX_QUALITY = 0x2F
     255,
 
-    175, // REG_INPUT_VOLTAGE = 0x31
-    1, // REG_LOCK = 0x32
+    /* Timing budget, EEPROM */
+    255, // REG_MAIN_TIMING_BUDGET = 0xD0
+    1, // REG_MAIN_DISTANCE_MODE = 0xD1
+    255, // REG_AUX_TIMING_BUDGET = 0xD2
+    1, // REG_AUX_DISTANCE_MODE = 0xD3
+
+    /* Timing budget, RAM */
+    255, // REG_MAIN_MEASURE_RATE = 0xD4
+    255,
+    255, // REG_AUX_MEASURE_RATE = 0xD6
+    255,
+
+    /* External trigger, EEPROM */
+    1, // REG_EXTERNAL_TRIGGER = 0xD8
+    255, // REG_TRIGGER_DELAY = 0xD9
+
+    /* External trigger, RAM */
+    3, // REG_TRIGGER = 0xDA
+
+    /* Clock synchronization, RAM */
+    255, // REG_SYNC_TIME = 0xDB
+    255,
+    255,
+    255,
+    255, // REG_SYNC_ERROR = 0xDF
+    255,
+    255, // REG_SYNC_DRIFT = 0xE1
+    255,
+    255, // REG_SYNC_COUNT = 0xE3
+
+    /* Profiles, RAM */
+    PROFILE_COUNT, // REG_PROFILE = 0xE4
+
+    /* Conditional read, EEPROM */
+    15, // REG_NEW_DATA_SOURCES = 0xE5
+
+    /* Time to contact, EEPROM */
+    255, // REG_COLLISION_ALARM = 0xE6
+    255,
+
+    /* Time to contact, RAM */
+    255, // REG_MAIN_TIME_TO_CONTACT = 0xE8
+    255,
+    255, // REG_AUX_TIME_TO_CONTACT = 0xEA
+    255,
 };
 
-uint8_t RegisterStorage::eeprom_default[EEPROM_AREA_SIZE] = {
+const uint8_t RegisterStorage::default_value[REGISTER_SIZE] PROGMEM = {
     /* EEPROM area */
     MODEL_NB_LW, // REG_MODEL_NUMBER = 0x00
     MODEL_NB_HW,
@@ -357,5 +1573,607 @@ uint8_t RegisterStorage::eeprom_default[EEPROM_AREA_SIZE] = {
 
     0, // Reserved (0x1E - 0x1F)
     0,
+
+    /* RAM area */
+    0, // REG_MAIN_ENABLED = 0x20
+    0, // REG_AUX_ENABLED = 0x21
+    0, // REG_WIRING_STATUS = 0x22
+
+    0, // REG_MAIN_MCSLR = 0x23
+    0, // REG_MAIN_RANGE = 0x24
+    0,
+    0, // REG_MAIN_RAW_RANGE = 0x26
+    0,
+    0, // REG_MAIN_QUALITY = 0x28
+    0,
+
+    0, // REG_AUX_MCSLR = 0x2A
+    0, // REG_AUX_RANGE = 0x2B
+    0,
+    0, // REG_AUX_RAW_RANGE = 0x2D
+    0,
+    0, // REG_AUX_QUALITY = 0x2F
+    0,
+
+    0, // REG_INPUT_VOLTAGE = 0x31
+    0, // REG_LOCK = 0x32
+
+    /* Adaptive period, EEPROM */
+    0, // REG_MAIN_ADAPTIVE_PERIOD = 0x33
+    0x00, // REG_MAIN_MIN_PERIOD = 0x34
+    0x00,
+    0xF4, // REG_MAIN_MAX_PERIOD = 0x36
+    0x01,
+
+    0, // REG_AUX_ADAPTIVE_PERIOD = 0x38
+    0x00, // REG_AUX_MIN_PERIOD = 0x39
+    0x00,
+    0xF4, // REG_AUX_MAX_PERIOD = 0x3B
+    0x01,
+
+    /* Adaptive period, RAM */
+    0, // REG_MAIN_CURRENT_PERIOD = 0x3D
+    0,
+    0, // REG_MAIN_RANGE_RATE = 0x3F
+    0,
+
+    0, // REG_AUX_CURRENT_PERIOD = 0x41
+    0,
+    0, // REG_AUX_RANGE_RATE = 0x43
+    0,
+
+    /* Interleaved mode, EEPROM */
+    0, // REG_INTERLEAVED_MODE = 0x45
+    0x00, // REG_MAIN_OFFSET = 0x46
+    0x00,
+    0x00, // REG_AUX_OFFSET = 0x48
+    0x00,
+
+    /* Interleaved mode, RAM */
+    0, // REG_MERGED_MCSLR = 0x4A
+    0, // REG_MERGED_RANGE = 0x4B
+    0,
+    0, // REG_MERGED_TIMESTAMP = 0x4D
+    0,
+    0, // REG_MERGED_SOURCE = 0x4F
+
+    /* Fault recovery, RAM */
+    0, // REG_MAIN_RECOVERY_COUNT = 0x50
+    0, // REG_AUX_RECOVERY_COUNT = 0x51
+
+    /* Soft reset, EEPROM */
+    0, // REG_WARM_RESET = 0x52
+
+    /* Trace, RAM */
+    0, // REG_TRACE_COUNT = 0x53
+    0, // REG_TRACE_DATA = 0x54
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Statistics, EEPROM */
+    0x64, // REG_STATS_WINDOW = 0x64
+    0x00,
+    0xFA, // REG_STATS_BIN_WIDTH = 0x66
+    0x00,
+
+    /* Statistics, RAM */
+    0, // REG_STATS_RESET = 0x68
+
+    /* Page window, RAM */
+    0, // REG_PAGE_SELECT = 0x69
+    0, // REG_PAGE_DATA = 0x6A
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Calibration, EEPROM */
+    0x00, // REG_MAIN_CAL_OFFSET = 0x8A
+    0x00,
+    0x00, // REG_MAIN_CAL_GAIN = 0x8C
+    0x04,
+    0x00, // REG_AUX_CAL_OFFSET = 0x8E
+    0x00,
+    0x00, // REG_AUX_CAL_GAIN = 0x90
+    0x04,
+
+    /* Measurement frame, RAM */
+    0, // REG_FRAME_SEQ = 0x92
+    0, // REG_FRAME_UPDATED = 0x93
+    0, // REG_FRAME_MAIN_RANGE = 0x94
+    0,
+    0, // REG_FRAME_AUX_RANGE = 0x96
+    0,
+    0, // REG_FRAME_TIMESTAMP = 0x98
+    0,
+
+    /* Communication, RAM */
+    0, // REG_REAL_BAUDRATE = 0x9A
+    0,
+    0,
+    0,
+
+    /* Outlier rejection, EEPROM */
+    0x00, // REG_OUTLIER_GATE = 0x9E
+    0x00,
+    2, // REG_OUTLIER_CONFIRM = 0xA0
+
+    /* Outlier rejection, RAM */
+    0, // REG_MAIN_VALIDITY = 0xA1
+    0, // REG_AUX_VALIDITY = 0xA2
+    0, // REG_MAIN_REJECT_COUNT = 0xA3
+    0,
+    0, // REG_AUX_REJECT_COUNT = 0xA5
+    0,
+
+    /* Idle sleep, EEPROM */
+    1, // REG_IDLE_SLEEP = 0xA7
+
+    /* Idle sleep, RAM */
+    0, // REG_WAKEUP_COUNT = 0xA8
+    0,
+    0,
+    0,
+    0, // REG_SLEEP_TIME = 0xAC
+    0,
+    0,
+    0,
+
+    /* Indirect access, EEPROM */
+    255, // REG_INDIRECT_ADDRESS = 0xB0
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+    255,
+
+    /* Indirect access, RAM */
+    0, // REG_INDIRECT_DATA = 0xC0
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+
+    /* Timing budget, EEPROM */
+    33, // REG_MAIN_TIMING_BUDGET = 0xD0
+    1, // REG_MAIN_DISTANCE_MODE = 0xD1
+    33, // REG_AUX_TIMING_BUDGET = 0xD2
+    1, // REG_AUX_DISTANCE_MODE = 0xD3
+
+    /* Timing budget, RAM */
+    0, // REG_MAIN_MEASURE_RATE = 0xD4
+    0,
+    0, // REG_AUX_MEASURE_RATE = 0xD6
+    0,
+
+    /* External trigger, EEPROM */
+    0, // REG_EXTERNAL_TRIGGER = 0xD8
+    0, // REG_TRIGGER_DELAY = 0xD9
+
+    /* External trigger, RAM */
+    0, // REG_TRIGGER = 0xDA
+
+    /* Clock synchronization, RAM */
+    0, // REG_SYNC_TIME = 0xDB
+    0,
+    0,
+    0,
+    0, // REG_SYNC_ERROR = 0xDF
+    0,
+    0, // REG_SYNC_DRIFT = 0xE1
+    0,
+    0, // REG_SYNC_COUNT = 0xE3
+
+    /* Profiles, RAM */
+    0, // REG_PROFILE = 0xE4
+
+    /* Conditional read, EEPROM */
+    0, // REG_NEW_DATA_SOURCES = 0xE5
+
+    /* Time to contact, EEPROM */
+    0x00, // REG_COLLISION_ALARM = 0xE6
+    0x00,
+
+    /* Time to contact, RAM */
+    0xFF, // REG_MAIN_TIME_TO_CONTACT = 0xE8
+    0xFF,
+    0xFF, // REG_AUX_TIME_TO_CONTACT = 0xEA
+    0xFF,
+};
+
+const uint8_t RegisterStorage::hook[REGISTER_SIZE] PROGMEM = {
+    /* EEPROM area */
+    HOOK_NONE, // REG_MODEL_NUMBER = 0x00
+    HOOK_NONE,
+    HOOK_NONE, // REG_FIRMWARE_VERSION = 0x02
+
+    HOOK_COMMUNICATION, // REG_ID = 0x03
+    HOOK_COMMUNICATION, // REG_BAUDRATE = 0x04
+    HOOK_COMMUNICATION, // REG_RETURN_DELAY_TIME = 0x05
+    HOOK_COMMUNICATION, // REG_STATUS_RETURN_LEVEL = 0x06
+
+    HOOK_NONE, // REG_MAIN_MIN_RANGE = 0x07
+    HOOK_NONE,
+    HOOK_NONE, // REG_MAIN_MAX_RANGE = 0x09
+    HOOK_NONE,
+    HOOK_NONE, // REG_MAIN_QUALITY_THRESHOLD = 0x0B
+    HOOK_NONE,
+    HOOK_NONE, // REG_MAIN_PERIOD = 0x0D
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+
+    HOOK_NONE, // REG_AUX_MIN_RANGE = 0x11
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_MAX_RANGE = 0x13
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_QUALITY_THRESHOLD = 0x15
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_PERIOD = 0x17
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+
+    HOOK_NONE, // REG_AUTO_START = 0x1B
+    HOOK_NONE, // REG_MAIN_POLLING = 0x1C
+    HOOK_NONE, // REG_AUX_POLLING = 0x1D
+
+    HOOK_NONE, // Reserved (0x1E - 0x1F)
+    HOOK_NONE,
+
+    /* RAM area */
+    HOOK_NONE, // REG_MAIN_ENABLED = 0x20
+    HOOK_NONE, // REG_AUX_ENABLED = 0x21
+    HOOK_NONE, // REG_WIRING_STATUS = 0x22
+
+    HOOK_NONE, // REG_MAIN_MCSLR = 0x23
+    HOOK_MAIN_RANGE, // REG_MAIN_RANGE = 0x24
+    HOOK_MAIN_RANGE,
+    HOOK_MAIN_RANGE, // REG_MAIN_RAW_RANGE = 0x26
+    HOOK_MAIN_RANGE,
+    HOOK_MAIN_RANGE, // REG_MAIN_QUALITY = 0x28
+    HOOK_MAIN_RANGE,
+
+    HOOK_NONE, // REG_AUX_MCSLR = 0x2A
+    HOOK_AUX_RANGE, // REG_AUX_RANGE = 0x2B
+    HOOK_AUX_RANGE,
+    HOOK_AUX_RANGE, // REG_AUX_RAW_RANGE = 0x2D
+    HOOK_AUX_RANGE,
+    HOOK_AUX_RANGE, // REG_AUX_QUALITY = 0x2F
+    HOOK_AUX_RANGE,
+
+    HOOK_INPUT_VOLTAGE, // REG_INPUT_VOLTAGE = 0x31
+    HOOK_NONE, // REG_LOCK = 0x32
+
+    /* Adaptive period, EEPROM */
+    HOOK_NONE, // REG_MAIN_ADAPTIVE_PERIOD = 0x33
+    HOOK_NONE, // REG_MAIN_MIN_PERIOD = 0x34
+    HOOK_NONE,
+    HOOK_NONE, // REG_MAIN_MAX_PERIOD = 0x36
+    HOOK_NONE,
+
+    HOOK_NONE, // REG_AUX_ADAPTIVE_PERIOD = 0x38
+    HOOK_NONE, // REG_AUX_MIN_PERIOD = 0x39
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_MAX_PERIOD = 0x3B
+    HOOK_NONE,
+
+    /* Adaptive period, RAM */
+    HOOK_NONE, // REG_MAIN_CURRENT_PERIOD = 0x3D
+    HOOK_NONE,
+    HOOK_NONE, // REG_MAIN_RANGE_RATE = 0x3F
+    HOOK_NONE,
+
+    HOOK_NONE, // REG_AUX_CURRENT_PERIOD = 0x41
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_RANGE_RATE = 0x43
+    HOOK_NONE,
+
+    /* Interleaved mode, EEPROM */
+    HOOK_NONE, // REG_INTERLEAVED_MODE = 0x45
+    HOOK_NONE, // REG_MAIN_OFFSET = 0x46
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_OFFSET = 0x48
+    HOOK_NONE,
+
+    /* Interleaved mode, RAM */
+    HOOK_NONE, // REG_MERGED_MCSLR = 0x4A
+    HOOK_MERGED_RANGE, // REG_MERGED_RANGE = 0x4B
+    HOOK_MERGED_RANGE,
+    HOOK_MERGED_RANGE, // REG_MERGED_TIMESTAMP = 0x4D
+    HOOK_MERGED_RANGE,
+    HOOK_MERGED_RANGE, // REG_MERGED_SOURCE = 0x4F
+
+    /* Fault recovery, RAM */
+    HOOK_NONE, // REG_MAIN_RECOVERY_COUNT = 0x50
+    HOOK_NONE, // REG_AUX_RECOVERY_COUNT = 0x51
+
+    /* Soft reset, EEPROM */
+    HOOK_NONE, // REG_WARM_RESET = 0x52
+
+    /* Trace, RAM */
+    HOOK_TRACE, // REG_TRACE_COUNT = 0x53
+    HOOK_TRACE, // REG_TRACE_DATA = 0x54
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+    HOOK_TRACE,
+
+    /* Statistics, EEPROM */
+    HOOK_NONE, // REG_STATS_WINDOW = 0x64
+    HOOK_NONE,
+    HOOK_NONE, // REG_STATS_BIN_WIDTH = 0x66
+    HOOK_NONE,
+
+    /* Statistics, RAM */
+    HOOK_NONE, // REG_STATS_RESET = 0x68
+
+    /* Page window, RAM */
+    HOOK_NONE, // REG_PAGE_SELECT = 0x69
+    HOOK_PAGE, // REG_PAGE_DATA = 0x6A
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+    HOOK_PAGE,
+
+    /* Calibration, EEPROM */
+    HOOK_NONE, // REG_MAIN_CAL_OFFSET = 0x8A
+    HOOK_NONE,
+    HOOK_NONE, // REG_MAIN_CAL_GAIN = 0x8C
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_CAL_OFFSET = 0x8E
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_CAL_GAIN = 0x90
+    HOOK_NONE,
+
+    /* Measurement frame, RAM */
+    HOOK_FRAME, // REG_FRAME_SEQ = 0x92
+    HOOK_NONE, // REG_FRAME_UPDATED = 0x93
+    HOOK_NONE, // REG_FRAME_MAIN_RANGE = 0x94
+    HOOK_NONE,
+    HOOK_NONE, // REG_FRAME_AUX_RANGE = 0x96
+    HOOK_NONE,
+    HOOK_NONE, // REG_FRAME_TIMESTAMP = 0x98
+    HOOK_NONE,
+
+    /* Communication, RAM */
+    HOOK_NONE, // REG_REAL_BAUDRATE = 0x9A
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+
+    /* Outlier rejection, EEPROM */
+    HOOK_NONE, // REG_OUTLIER_GATE = 0x9E
+    HOOK_NONE,
+    HOOK_NONE, // REG_OUTLIER_CONFIRM = 0xA0
+
+    /* Outlier rejection, RAM */
+    HOOK_NONE, // REG_MAIN_VALIDITY = 0xA1
+    HOOK_NONE, // REG_AUX_VALIDITY = 0xA2
+    HOOK_NONE, // REG_MAIN_REJECT_COUNT = 0xA3
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_REJECT_COUNT = 0xA5
+    HOOK_NONE,
+
+    /* Idle sleep, EEPROM */
+    HOOK_NONE, // REG_IDLE_SLEEP = 0xA7
+
+    /* Idle sleep, RAM */
+    HOOK_NONE, // REG_WAKEUP_COUNT = 0xA8
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE, // REG_SLEEP_TIME = 0xAC
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+
+    /* Indirect access, EEPROM */
+    HOOK_NONE, // REG_INDIRECT_ADDRESS = 0xB0
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+
+    /* Indirect access, RAM */
+    HOOK_NONE, // REG_INDIRECT_DATA = 0xC0
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+    HOOK_NONE,
+
+    /* Timing budget, EEPROM */
+    HOOK_NONE, // REG_MAIN_TIMING_BUDGET = 0xD0
+    HOOK_NONE, // REG_MAIN_DISTANCE_MODE = 0xD1
+    HOOK_NONE, // REG_AUX_TIMING_BUDGET = 0xD2
+    HOOK_NONE, // REG_AUX_DISTANCE_MODE = 0xD3
+
+    /* Timing budget, RAM */
+    HOOK_NONE, // REG_MAIN_MEASURE_RATE = 0xD4
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_MEASURE_RATE = 0xD6
+    HOOK_NONE,
+
+    /* External trigger, EEPROM */
+    HOOK_NONE, // REG_EXTERNAL_TRIGGER = 0xD8
+    HOOK_NONE, // REG_TRIGGER_DELAY = 0xD9
+
+    /* External trigger, RAM */
+    HOOK_TRIGGER, // REG_TRIGGER = 0xDA
+
+    /* Clock synchronization, RAM */
+    HOOK_SYNC_TIME, // REG_SYNC_TIME = 0xDB
+    HOOK_SYNC_TIME,
+    HOOK_SYNC_TIME,
+    HOOK_SYNC_TIME,
+    HOOK_NONE, // REG_SYNC_ERROR = 0xDF
+    HOOK_NONE,
+    HOOK_NONE, // REG_SYNC_DRIFT = 0xE1
+    HOOK_NONE,
+    HOOK_NONE, // REG_SYNC_COUNT = 0xE3
+
+    /* Profiles, RAM */
+    HOOK_PROFILE, // REG_PROFILE = 0xE4
+
+    /* Conditional read, EEPROM */
+    HOOK_NONE, // REG_NEW_DATA_SOURCES = 0xE5
+
+    /* Time to contact, EEPROM */
+    HOOK_NONE, // REG_COLLISION_ALARM = 0xE6
+    HOOK_NONE,
+
+    /* Time to contact, RAM */
+    HOOK_NONE, // REG_MAIN_TIME_TO_CONTACT = 0xE8
+    HOOK_NONE,
+    HOOK_NONE, // REG_AUX_TIME_TO_CONTACT = 0xEA
+    HOOK_NONE,
 };
 
+
+const uint8_t RegisterStorage::profile_registers[2][PROFILE_SIZE] PROGMEM = {
+    {
+        REG_MAIN_MIN_RANGE, REG_MAIN_MIN_RANGE + 1,
+        REG_MAIN_MAX_RANGE, REG_MAIN_MAX_RANGE + 1,
+        REG_MAIN_QUALITY_THRESHOLD, REG_MAIN_QUALITY_THRESHOLD + 1,
+        REG_MAIN_PERIOD, REG_MAIN_PERIOD + 1, REG_MAIN_PERIOD + 2, REG_MAIN_PERIOD + 3,
+        REG_MAIN_POLLING,
+        REG_MAIN_ADAPTIVE_PERIOD,
+        REG_MAIN_MIN_PERIOD, REG_MAIN_MIN_PERIOD + 1,
+        REG_MAIN_MAX_PERIOD, REG_MAIN_MAX_PERIOD + 1,
+        REG_MAIN_TIMING_BUDGET,
+        REG_MAIN_DISTANCE_MODE
+    },
+    {
+        REG_AUX_MIN_RANGE, REG_AUX_MIN_RANGE + 1,
+        REG_AUX_MAX_RANGE, REG_AUX_MAX_RANGE + 1,
+        REG_AUX_QUALITY_THRESHOLD, REG_AUX_QUALITY_THRESHOLD + 1,
+        REG_AUX_PERIOD, REG_AUX_PERIOD + 1, REG_AUX_PERIOD + 2, REG_AUX_PERIOD + 3,
+        REG_AUX_POLLING,
+        REG_AUX_ADAPTIVE_PERIOD,
+        REG_AUX_MIN_PERIOD, REG_AUX_MIN_PERIOD + 1,
+        REG_AUX_MAX_PERIOD, REG_AUX_MAX_PERIOD + 1,
+        REG_AUX_TIMING_BUDGET,
+        REG_AUX_DISTANCE_MODE
+    }
+};
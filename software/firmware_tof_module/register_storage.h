@@ -3,8 +3,14 @@
 
 #include <Arduino.h>
 
-#define REGISTER_SIZE 51
-#define EEPROM_AREA_SIZE 32
+#define REGISTER_SIZE 236
+#define TRACE_WINDOW_SIZE 16
+#define PAGE_SIZE 32
+#define FRAME_SIZE 8
+#define INDIRECT_SIZE 16
+#define PROFILE_COUNT 3 // banks, profile 0 being the configuration stored in the registers
+#define PROFILE_SIZE 18 // bytes of a sensor in a bank
+#define EEPROM_PAGE_ADDR 0x100 // EEPROM pages are stored after the register area
 
 
 enum RegisterMap
@@ -49,6 +55,227 @@ enum RegisterMap
 
     REG_INPUT_VOLTAGE = 0x31,
     REG_LOCK = 0x32,
+
+    /* Adaptive period, EEPROM */
+    REG_MAIN_ADAPTIVE_PERIOD = 0x33,
+    REG_MAIN_MIN_PERIOD = 0x34,
+    REG_MAIN_MAX_PERIOD = 0x36,
+    REG_AUX_ADAPTIVE_PERIOD = 0x38,
+    REG_AUX_MIN_PERIOD = 0x39,
+    REG_AUX_MAX_PERIOD = 0x3B,
+
+    /* Adaptive period, RAM */
+    REG_MAIN_CURRENT_PERIOD = 0x3D,
+    REG_MAIN_RANGE_RATE = 0x3F,
+    REG_AUX_CURRENT_PERIOD = 0x41,
+    REG_AUX_RANGE_RATE = 0x43,
+
+    /* Interleaved mode, EEPROM */
+    REG_INTERLEAVED_MODE = 0x45,
+    REG_MAIN_OFFSET = 0x46,
+    REG_AUX_OFFSET = 0x48,
+
+    /* Interleaved mode, RAM */
+    REG_MERGED_MCSLR = 0x4A,
+    REG_MERGED_RANGE = 0x4B,
+    REG_MERGED_TIMESTAMP = 0x4D,
+    REG_MERGED_SOURCE = 0x4F,
+
+    /* Fault recovery, RAM */
+    REG_MAIN_RECOVERY_COUNT = 0x50,
+    REG_AUX_RECOVERY_COUNT = 0x51,
+
+    /* Soft reset, EEPROM
+     * A warm reset keeps the configuration and the sensor measurements, and
+     * restarts the synchronization, statistics, counters and schedules */
+    REG_WARM_RESET = 0x52,
+
+    /* Trace, RAM */
+    REG_TRACE_COUNT = 0x53,
+    REG_TRACE_DATA = 0x54,
+
+    /* Statistics, EEPROM */
+    REG_STATS_WINDOW = 0x64,
+    REG_STATS_BIN_WIDTH = 0x66,
+
+    /* Statistics, RAM */
+    REG_STATS_RESET = 0x68,
+
+    /* Page window, RAM */
+    REG_PAGE_SELECT = 0x69,
+    REG_PAGE_DATA = 0x6A,
+
+    /* Calibration, EEPROM */
+    REG_MAIN_CAL_OFFSET = 0x8A,
+    REG_MAIN_CAL_GAIN = 0x8C,
+    REG_AUX_CAL_OFFSET = 0x8E,
+    REG_AUX_CAL_GAIN = 0x90,
+
+    /* Measurement frame, RAM */
+    REG_FRAME_SEQ = 0x92,
+    REG_FRAME_UPDATED = 0x93,
+    REG_FRAME_MAIN_RANGE = 0x94,
+    REG_FRAME_AUX_RANGE = 0x96,
+    REG_FRAME_TIMESTAMP = 0x98,
+
+    /* Communication, RAM */
+    REG_REAL_BAUDRATE = 0x9A,
+
+    /* Outlier rejection, EEPROM */
+    REG_OUTLIER_GATE = 0x9E,
+    REG_OUTLIER_CONFIRM = 0xA0,
+
+    /* Outlier rejection, RAM */
+    REG_MAIN_VALIDITY = 0xA1,
+    REG_AUX_VALIDITY = 0xA2,
+    REG_MAIN_REJECT_COUNT = 0xA3,
+    REG_AUX_REJECT_COUNT = 0xA5,
+
+    /* Idle sleep, EEPROM */
+    REG_IDLE_SLEEP = 0xA7,
+
+    /* Idle sleep, RAM */
+    REG_WAKEUP_COUNT = 0xA8,
+    REG_SLEEP_TIME = 0xAC,
+
+    /* Indirect access, EEPROM */
+    REG_INDIRECT_ADDRESS = 0xB0,
+
+    /* Indirect access, RAM */
+    REG_INDIRECT_DATA = 0xC0,
+
+    /* Timing budget, EEPROM */
+    REG_MAIN_TIMING_BUDGET = 0xD0,
+    REG_MAIN_DISTANCE_MODE = 0xD1,
+    REG_AUX_TIMING_BUDGET = 0xD2,
+    REG_AUX_DISTANCE_MODE = 0xD3,
+
+    /* Timing budget, RAM */
+    REG_MAIN_MEASURE_RATE = 0xD4,
+    REG_AUX_MEASURE_RATE = 0xD6,
+
+    /* External trigger, EEPROM */
+    REG_EXTERNAL_TRIGGER = 0xD8,
+    REG_TRIGGER_DELAY = 0xD9,
+
+    /* External trigger, RAM */
+    REG_TRIGGER = 0xDA,
+
+    /* Clock synchronization, RAM */
+    REG_SYNC_TIME = 0xDB,
+    REG_SYNC_ERROR = 0xDF,
+    REG_SYNC_DRIFT = 0xE1,
+    REG_SYNC_COUNT = 0xE3,
+
+    /* Profiles, RAM */
+    REG_PROFILE = 0xE4,
+
+    /* Conditional read, EEPROM */
+    REG_NEW_DATA_SOURCES = 0xE5,
+
+    /* Time to contact, EEPROM */
+    REG_COLLISION_ALARM = 0xE6,
+
+    /* Time to contact, RAM */
+    REG_MAIN_TIME_TO_CONTACT = 0xE8,
+    REG_AUX_TIME_TO_CONTACT = 0xEA,
+};
+
+
+/* Bits of REG_WIRING_STATUS */
+#define WIRING_MAIN 0x01
+#define WIRING_AUX 0x02
+#define WIRING_BOOTING 0x80 // first power on of the sensors not done, the other bits are not final
+
+
+/* Bits of REG_FRAME_UPDATED */
+#define FRAME_MAIN_UPDATED 0x01
+#define FRAME_AUX_UPDATED 0x02
+
+
+/* Bits of REG_TRIGGER */
+#define TRIGGER_MAIN 0x01
+#define TRIGGER_AUX 0x02
+
+
+/* Bits of REG_NEW_DATA_SOURCES, data reported by STATUS_NEW_DATA */
+#define NEW_DATA_MAIN 0x01 // REG_MAIN_MCSLR not null
+#define NEW_DATA_AUX 0x02 // REG_AUX_MCSLR not null
+#define NEW_DATA_MERGED 0x04 // REG_MERGED_MCSLR not null
+#define NEW_DATA_FRAME 0x08 // frame published since the last read of REG_FRAME_SEQ
+
+
+/* Values of REG_*_VALIDITY, classification of the last measurement */
+enum Validity
+{
+    VALIDITY_VALID = 0, // published in REG_*_RANGE
+    VALIDITY_TOO_CLOSE = 1, // published, REG_*_RANGE is OBSTACLE_TOO_CLOSE
+    VALIDITY_NO_OBSTACLE = 2, // published, REG_*_RANGE is NO_OBSTACLE
+    VALIDITY_OUTLIER = 3, // rejected, REG_*_RANGE keeps the previous value
+};
+
+
+/* Values of REG_*_DISTANCE_MODE */
+enum DistanceMode
+{
+    DISTANCE_MODE_SHORT = 0, // better ambient light immunity
+    DISTANCE_MODE_LONG = 1, // longer range, at the cost of more noise
+};
+
+
+/* Blocks of data too large for the register map, accessed through the page
+ * window: the page is chosen by writing REG_PAGE_SELECT, then its content is
+ * read in REG_PAGE_DATA. Writing REG_PAGE_DATA stores the whole window in
+ * the selected page if it is writable. */
+enum Page
+{
+    PAGE_MAIN_STATISTICS = 0,
+    PAGE_AUX_STATISTICS = 1,
+    PAGE_MAIN_CALIBRATION = 2,
+    PAGE_AUX_CALIBRATION = 3,
+    PAGE_PROFILE = 4, // main then aux sensor of each bank, from bank 1
+    PAGE_COUNT = PAGE_PROFILE + 2 * PROFILE_COUNT
+};
+
+
+/* Pages stored in EEPROM, starting at EEPROM_PAGE_ADDR */
+enum EepromPage
+{
+    EEPROM_PAGE_MAIN_CALIBRATION = 0,
+    EEPROM_PAGE_AUX_CALIBRATION = 1,
+    EEPROM_PAGE_PROFILE = 2, // same order as PAGE_PROFILE
+    EEPROM_PAGE_COUNT = EEPROM_PAGE_PROFILE + 2 * PROFILE_COUNT
+};
+
+
+/* Side effects of the accesses of the master: each register is attached to
+ * at most one hook by the hook table of RegisterStorage, the hooks of the
+ * registers being contiguous. */
+enum Hook
+{
+    HOOK_NONE = 0,
+    HOOK_COMMUNICATION, // REG_ID to REG_STATUS_RETURN_LEVEL
+    HOOK_MAIN_RANGE, // REG_MAIN_RANGE to REG_MAIN_QUALITY
+    HOOK_AUX_RANGE, // REG_AUX_RANGE to REG_AUX_QUALITY
+    HOOK_INPUT_VOLTAGE,
+    HOOK_MERGED_RANGE, // REG_MERGED_RANGE to REG_MERGED_SOURCE
+    HOOK_TRACE, // REG_TRACE_COUNT and the trace window
+    HOOK_PAGE, // page window
+    HOOK_FRAME, // REG_FRAME_SEQ
+    HOOK_TRIGGER,
+    HOOK_SYNC_TIME,
+    HOOK_PROFILE,
+    HOOK_COUNT
+};
+
+
+/* Handlers of a hook, nullptr if not needed. address and size are the ones
+ * of the whole access. */
+struct HookHandlers
+{
+    void (*prepareRead)(uint8_t address, uint8_t size); // computes the registers before they are read
+    void (*finishRead)(uint8_t address, uint8_t size); // after the read
+    uint8_t (*written)(uint8_t address, uint8_t size); // after a write committing one of its bytes, returns an error code
 };
 
 
@@ -60,12 +287,62 @@ public:
     void init();
     void resetEEPROM();
 
+    /* Each byte of the indirect window (INDIRECT_SIZE registers from
+     * REG_INDIRECT_DATA) reads as the register whose address is stored at
+     * the same index in the indirect table (REG_INDIRECT_ADDRESS), so that
+     * scattered registers can be gathered in a single read. Entries out of
+     * the register map or pointing into the window read as 0. */
     void read(uint8_t address, uint8_t size, uint8_t* data);
+    uint8_t indirectSource(uint8_t index) const { return mData[REG_INDIRECT_ADDRESS + index]; }
+
+    /* Accesses of the master, which call the hooks of the registers: the
+     * read hooks of each hook met once, including the ones of the registers
+     * read through the indirect window, and the write hooks once the whole
+     * write succeeded. handlers is a table of HOOK_COUNT entries in flash. */
+    void setHooks(const HookHandlers *handlers) { mHooks = handlers; }
+    void masterRead(uint8_t address, uint8_t size, uint8_t* data);
     uint8_t write(uint8_t address, uint8_t size, const uint8_t* data);
 
     /* Allow to write read-only registers but only in RAM area */
     void writeRAM(uint8_t address, uint8_t size, const uint8_t* data);
 
+    /* Access to size bytes from offset in the EEPROM pages, PAGE_SIZE bytes
+     * each */
+    void readEEPROMPage(uint8_t page, uint8_t offset, uint8_t size, uint8_t* data);
+    void writeEEPROMPage(uint8_t page, uint8_t offset, uint8_t size, const uint8_t* data);
+
+    /* Transfers of the REG_PAGE_DATA window, copied in place rather than
+     * through a page buffer on the stack. loadPage() fills the window with
+     * size bytes of data, and zeroes the rest. */
+    void loadPage(const uint8_t* data, uint8_t size);
+    void loadEEPROMPage(uint8_t page);
+    void storeEEPROMPage(uint8_t page);
+
+    /* The measurement frame (FRAME_SIZE registers from REG_FRAME_SEQ) is
+     * double-buffered: writeFrame() only updates the back buffer, which is
+     * copied to the registers by publishFrame() along with a new sequence
+     * number, so that the master always reads a coherent frame. The sequence
+     * number goes from 1 to 255, 0 meaning that no frame was published. */
+    void writeFrame(uint8_t address, uint8_t size, const uint8_t* data);
+    void publishFrame();
+
+    /* Configuration profiles: a bank holds, for each sensor, the registers
+     * listed in profile_registers (range limits, quality threshold, period,
+     * polling, adaptive period, timing budget and distance mode). The banks
+     * are stored in EEPROM pages, and read from there when selected to save
+     * RAM. Writing REG_PROFILE copies the selected bank into the registers,
+     * in RAM only, so that the configuration is switched at once without
+     * writing the EEPROM. Profile 0 restores the configuration stored in
+     * EEPROM, which is the one used at startup. A register of the profile
+     * written while a bank is active changes the stored configuration, not
+     * the bank.
+     * A bank is read and written as PROFILE_SIZE bytes per sensor, in the
+     * order of profile_registers, through the REG_PAGE_DATA window.
+     * storeProfile() fails if a byte is out of the range of its register. */
+    void loadProfile(uint8_t bank, uint8_t sensor);
+    uint8_t storeProfile(uint8_t bank, uint8_t sensor);
+    void selectProfile(uint8_t profile);
+
     template<class T>
     void read(uint8_t address, T& data)
     {
@@ -84,30 +361,43 @@ public:
         writeRAM(address, sizeof(T), (const uint8_t*)&data);
     }
 
-    bool idChanged() const { return mIdChanged; }
-    bool baudrateChanged() const { return mBaudrateChanged; }
-    bool returnDelayTimeChanged() const { return mReturnDelayTimeChanged; }
-    bool statusReturnLevelChanged() const { return mStatusReturnLevelChanged; }
+    template<class T>
+    void writeFrame(uint8_t address, const T& data)
+    {
+        writeFrame(address, sizeof(T), (const uint8_t*)&data);
+    }
 
-    uint8_t getId() { mIdChanged = false; return mData[REG_ID]; }
-    uint8_t getBaudrate() { mBaudrateChanged = false; return mData[REG_BAUDRATE]; }
-    uint8_t getReturnDelayTime() { mReturnDelayTimeChanged = false; return mData[REG_RETURN_DELAY_TIME]; }
-    uint8_t getStatusReturnLevel() { mStatusReturnLevelChanged = false; return mData[REG_STATUS_RETURN_LEVEL]; }
+    /* Value of a register after a factory reset */
+    static uint8_t defaultValue(size_t address) { return pgm_read_byte(&default_value[address]); }
 
 private:
     bool checkMagic();
     void writeMagic();
+    void callReadHooks(uint8_t address, uint8_t size, bool finish);
+    uint8_t callWriteHooks(uint8_t address, uint8_t size, const uint8_t * data);
+    static bool accepts(size_t address, uint8_t value);
 
-    bool mIdChanged;
-    bool mBaudrateChanged;
-    bool mReturnDelayTimeChanged;
-    bool mStatusReturnLevelChanged;
+    static bool isWritable(size_t address) { return pgm_read_byte(&writable[address]); }
+    static bool isPersistent(size_t address) { return pgm_read_byte(&persistent[address]); }
+    static uint8_t minRange(size_t address) { return pgm_read_byte(&min_range[address]); }
+    static uint8_t maxRange(size_t address) { return pgm_read_byte(&max_range[address]); }
+    static uint8_t hookOf(size_t address) { return pgm_read_byte(&hook[address]); }
+    static uint8_t profileRegister(uint8_t sensor, uint8_t index) { return pgm_read_byte(&profile_registers[sensor][index]); }
+
+    const HookHandlers *mHooks;
 
     uint8_t mData[REGISTER_SIZE];
-    static bool writable[REGISTER_SIZE];
-    static uint8_t min_range[REGISTER_SIZE];
-    static uint8_t max_range[REGISTER_SIZE];
-    static uint8_t eeprom_default[EEPROM_AREA_SIZE];
+    uint8_t mFrame[FRAME_SIZE]; // back buffer of the measurement frame
+
+    /* Register attributes, stored in flash to keep RAM usage independent of
+     * the size of the register map */
+    static const bool writable[REGISTER_SIZE] PROGMEM;
+    static const bool persistent[REGISTER_SIZE] PROGMEM; // stored in EEPROM at the same address
+    static const uint8_t min_range[REGISTER_SIZE] PROGMEM;
+    static const uint8_t max_range[REGISTER_SIZE] PROGMEM;
+    static const uint8_t default_value[REGISTER_SIZE] PROGMEM;
+    static const uint8_t hook[REGISTER_SIZE] PROGMEM;
+    static const uint8_t profile_registers[2][PROFILE_SIZE] PROGMEM;
 
     const uint8_t mRangeErrorCode;
 };
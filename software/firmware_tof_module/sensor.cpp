@@ -1,4 +1,5 @@
 #include "sensor.h"
+#include "trace.h"
 
 /* The sensor will be set as faulty if it cannot give a valid reading in
  * more than TIMEOUT (ms) with:
@@ -7,52 +8,109 @@
  */
 #define PERIOD_FAULT_TIMER 3
 #define MINIMAL_FAULT_TIMER 100 // ms
+
+/* A faulty sensor is kept in standby during a delay before being powered on
+ * again. This delay starts at RECOVERY_MIN_DELAY and is doubled after each
+ * failed attempt, up to RECOVERY_MAX_DELAY.
+ */
+#define RECOVERY_MIN_DELAY 50 // ms
+#define RECOVERY_MAX_DELAY 10000 // ms
 #define DEBUG_MEASUREMENTS 0 // set to 1 to print all measurements on mErrorStream
 
+/* Set to 1 when the ToF-Sensor library provides setTimingBudget() and
+ * setLongRange() (see README.md). Otherwise the sensors keep the
+ * configuration of their power on, and only the default values of the
+ * timing budget and distance mode registers are accepted. */
+#ifndef SENSOR_CONFIG_API
+#define SENSOR_CONFIG_API 0
+#endif
+
+/* Adaptive period: the rate of change of the range between two consecutive
+ * measurements, beyond ADAPTIVE_NOISE, is used as a measure of the scene
+ * dynamics, so that the same motion gives the same decision at any period.
+ * The period is halved as soon as one rate exceeds ADAPTIVE_MOVING_RATE, and
+ * is increased by a quarter while the filtered rate stays below
+ * ADAPTIVE_STILL_RATE, at most once per ADAPTIVE_HOLD_TIME since each change
+ * restarts the ranging. Rates in between keep the period.
+ * The period always stays within the bounds set in the registers.
+ */
+#define ADAPTIVE_NOISE 5 // mm, variation ignored as ranging noise
+#define ADAPTIVE_MOVING_RATE 300 // mm/s
+#define ADAPTIVE_STILL_RATE 50 // mm/s
+#define ADAPTIVE_HOLD_TIME 1000 // ms
+#define ADAPTIVE_PERIOD_STEP 10 // ms, minimal increase of the period
+
+/* Velocity: the range is tracked by an alpha-beta filter, in fixed point with
+ * VELOCITY_SHIFT fractional bits, which smooths the velocity without the
+ * lag of an average of the range differences. The filter restarts after a
+ * gap of more than VELOCITY_MAX_GAP between two valid ranges.
+ * The time to contact is the range divided by the closing speed, above
+ * VELOCITY_MIN_CLOSING only so that the noise of a still scene does not give
+ * short times. It is 0 when the obstacle is too close, TIME_TO_CONTACT_NONE
+ * when it is not approaching.
+ */
+#define VELOCITY_SHIFT 4 // 1/16 mm, 1/16 mm/s
+#define VELOCITY_ALPHA_DIVIDER 2 // alpha = 1/2
+#define VELOCITY_BETA_DIVIDER 8 // beta = 1/8
+#define VELOCITY_MAX_GAP 500 // ms
+#define VELOCITY_MIN_CLOSING 20 // mm/s
+#define TIME_TO_CONTACT_NONE UINT16_MAX
+
+/* Timing budget: time allowed to the sensor for each measurement, a longer
+ * budget giving a more accurate range. The sensor cannot measure faster than
+ * its budget, so a non-null inter-measurement period is raised to at least
+ * BUDGET + TIMING_BUDGET_OVERHEAD. The budget and the distance mode are
+ * applied when the measurement starts, which is restarted on change.
+ */
+#define TIMING_BUDGET_OVERHEAD 2 // ms
+
+/* Calibration: the measured range R is corrected by the piecewise-linear
+ * table C stored in the sensor's calibration page, then scaled and offset:
+ * RANGE = (R + C(R)) * GAIN / CALIBRATION_GAIN_ONE + OFFSET
+ * The table is a list of CALIBRATION_POINTS points, each made of the range
+ * (uint16, mm) and the correction at this range (int16, mm), sorted by
+ * increasing range. A point with a null range ends the table. Outside of the
+ * table, the correction of the nearest point is used.
+ */
+#define CALIBRATION_POINTS (PAGE_SIZE / 4)
+#define CALIBRATION_GAIN_ONE 1024
+
+/* Outlier rejection: a range is compared with the reference, the last
+ * accepted range, and rejected if it differs by more than the gate. The gate
+ * narrows for weak returns, the quality Q being clamped to [T/2, 2T] with T
+ * the quality threshold:
+ * GATE_EFF = GATE * Q / (2 * T)
+ * A rejected range is not published. A real step of the range is accepted
+ * once CONFIRM consecutive samples agreed with each other within the gate.
+ * The reference is cleared when no obstacle is seen, and a null gate
+ * disables the rejection (default).
+ */
+
 Sensor::Sensor(RegisterStorage & aRegisterStorage, uint8_t aIndex,
-    uint8_t aAddress, uint8_t aResetPin, uint8_t aRegEnabled,
-    uint8_t aRegMinRange, uint8_t aRegMaxRange, uint8_t aRegQualityThreshold,
-    uint8_t aRegPeriod, uint8_t aRegPolling, uint8_t aRegMeasureCount,
-    uint8_t aRegRange, uint8_t aRegRawRange, uint8_t aRegQuality,
+    uint8_t aAddress, uint8_t aResetPin, const SensorRegisters &aRegisters,
     Stream *errStream) :
         mRegisters(aRegisterStorage),
         mSensor(aAddress, aResetPin),
         mIndex(aIndex),
-        mRegEnabled(aRegEnabled),
-        mRegMinRange(aRegMinRange),
-        mRegMaxRange(aRegMaxRange),
-        mRegQualityThreshold(aRegQualityThreshold),
-        mRegPeriod(aRegPeriod),
-        mRegPolling(aRegPolling),
-        mRegMeasureCount(aRegMeasureCount),
-        mRegRange(aRegRange),
-        mRegRawRange(aRegRawRange),
-        mRegQuality(aRegQuality),
+        mReg(aRegisters),
         mErrorStream(errStream)
 {
     mStatus = 0;
+    mTriggered = false;
+    mRecoveryCount = 0;
+    mRejectCount = 0;
     end();
 }
 
 void Sensor::begin()
 {
     mStatus = 0;
-    if (mSensor.powerON(false) == EXIT_SUCCESS) {
-        mWired = true;
-        uint8_t wiringStatus;
-        mRegisters.read(REG_WIRING_STATUS, wiringStatus);
-        wiringStatus |= (1 << mIndex);
-        mRegisters.writeRAM(REG_WIRING_STATUS, wiringStatus);
-    }
-    else if (mErrorStream) {
-        mErrorStream->print("Sensor #");
-        mErrorStream->print(mIndex);
-        mErrorStream->println(" not wired.");
-    }
+    mBooting = true;
+    mPowerStage = POWER_ON;
     uint8_t auto_start;
     mRegisters.read(REG_AUTO_START, auto_start);
-    mRegisters.writeRAM(mRegEnabled, auto_start);
-    mRegisters.read(mRegPolling, mPolling);
+    mRegisters.writeRAM(mReg.enabled, auto_start);
+    mRegisters.read(mReg.polling, mPolling);
 }
 
 void Sensor::end()
@@ -63,11 +121,41 @@ void Sensor::end()
     mLastMeasureTime = 0;
     mMeasurementReady = false;
     mPolling = false;
-    mRegisters.writeRAM(mRegEnabled, (uint8_t)0);
-    mRegisters.writeRAM(mRegMeasureCount, (uint8_t)0);
-    mRegisters.writeRAM(mRegRange, (uint16_t)0);
-    mRegisters.writeRAM(mRegRawRange, (uint16_t)0);
-    mRegisters.writeRAM(mRegQuality, (uint16_t)0);
+    mPeriod = 0;
+    mTimingBudget = 0;
+    mDistanceMode = 0;
+    mRejectedBudget = 0;
+    mRejectedMode = 0;
+    mRateStarted = false;
+    mMeasureInterval = 0;
+    mAdaptivePeriod = UINT16_MAX;
+    mLastRange = 0;
+    mLastRangeTime = 0;
+    mActivity = 0;
+    mAdaptiveTime = 0;
+    mTrackRange = 0;
+    mVelocity = 0;
+    mReference = 0;
+    mCandidate = 0;
+    mRejectStreak = 0;
+    mTriggerPending = false;
+    mNewSample = false;
+    mPowerStage = POWER_IDLE;
+    mBooting = false;
+    mPowerTime = 0;
+    mRecoveryDelay = RECOVERY_MIN_DELAY;
+    mRegisters.writeRAM(mReg.recoveryCount, mRecoveryCount);
+    mRegisters.writeRAM(mReg.rejectCount, mRejectCount);
+    mRegisters.writeRAM(mReg.validity, (uint8_t)VALIDITY_VALID);
+    mRegisters.writeRAM(mReg.enabled, (uint8_t)0);
+    mRegisters.writeRAM(mReg.measureCount, (uint8_t)0);
+    mRegisters.writeRAM(mReg.range, (uint16_t)0);
+    mRegisters.writeRAM(mReg.rawRange, (uint16_t)0);
+    mRegisters.writeRAM(mReg.quality, (uint16_t)0);
+    mRegisters.writeRAM(mReg.currentPeriod, (uint16_t)0);
+    mRegisters.writeRAM(mReg.rangeRate, (int16_t)0);
+    mRegisters.writeRAM(mReg.timeToContact, (uint16_t)TIME_TO_CONTACT_NONE);
+    mRegisters.writeRAM(mReg.measureRate, (uint16_t)0);
     uint8_t wiringStatus;
     mRegisters.read(REG_WIRING_STATUS, wiringStatus);
     wiringStatus &= ~(1 << mIndex);
@@ -76,25 +164,65 @@ void Sensor::end()
 
 void Sensor::update()
 {
+    uint32_t now = millis();
+    if (mPowerStage != POWER_IDLE) {
+        powerUp(now);
+        return;
+    }
+
     if (!mWired) {
         return;
     }
 
+    uint8_t stats_reset;
+    mRegisters.read(REG_STATS_RESET, stats_reset);
+    if (stats_reset & (1 << mIndex)) {
+        mStatistics.reset();
+        mRegisters.writeRAM(REG_STATS_RESET, (uint8_t)(stats_reset & ~(1 << mIndex)));
+    }
+
     bool enabled;
-    uint32_t period;
-    uint32_t now = millis();
-    mRegisters.read(mRegEnabled, enabled);
-    mRegisters.read(mRegPeriod, period);
+    uint32_t period = configuredPeriod();
+    mRegisters.read(mReg.enabled, enabled);
+    mRegisters.read(mReg.polling, mPolling);
+    if (mTriggered) {
+        if (!enabled) {
+            mTriggerPending = false;
+        }
+        enabled = mTriggerPending;
+        period = 0;
+    }
 
     if (mSensor.measurementStarted()) {
-        if (!enabled) {
+        if (!enabled || period != mPeriod || configChanged()) {
             mSensor.stopMeasurement();
         }
+        if (!enabled && !mTriggered) {
+            mRateStarted = false;
+            mMeasureInterval = 0;
+            mRegisters.writeRAM(mReg.measureRate, (uint16_t)0);
+            /* No stale alarm while the sensor does not measure */
+            mLastRange = 0;
+            mRegisters.writeRAM(mReg.rangeRate, (int16_t)0);
+            mRegisters.writeRAM(mReg.timeToContact, (uint16_t)TIME_TO_CONTACT_NONE);
+        }
     }
-    else if (enabled) {
-        mSensor.startMeasurement(period);
+    if (!mSensor.measurementStarted() && enabled) {
+        if (configChanged()) {
+            if (applyConfig() != EXIT_SUCCESS) {
+                startRecovery(now);
+                return;
+            }
+            /* The budget in use may not be the one of the registers */
+            if (!mTriggered) {
+                period = configuredPeriod();
+            }
+        }
+        mPeriod = period;
+        mSensor.startMeasurement(mPeriod);
         mMeasurementReady = false;
         mLastMeasureTime = now;
+        mRegisters.writeRAM(mReg.currentPeriod, (uint16_t)min(mPeriod, UINT16_MAX));
     }
 
     if (!mSensor.measurementStarted()) {
@@ -102,15 +230,8 @@ void Sensor::update()
     }
 
     if (now - mLastMeasureTime > 
-            max(PERIOD_FAULT_TIMER * period, MINIMAL_FAULT_TIMER)) {
-        mStatus = (1 << mIndex);
-        if (mErrorStream) {
-            mErrorStream->print("Sensor #");
-            mErrorStream->print(mIndex);
-            mErrorStream->println(" not responding.");
-        }
-        end();
-        begin();
+            max(PERIOD_FAULT_TIMER * mPeriod, MINIMAL_FAULT_TIMER)) {
+        startRecovery(now);
         return;
     }
 
@@ -122,9 +243,9 @@ void Sensor::update()
     uint16_t min_range;
     uint16_t max_range;
     uint16_t quality_threshold;
-    mRegisters.read(mRegMinRange, min_range);
-    mRegisters.read(mRegMaxRange, max_range);
-    mRegisters.read(mRegQualityThreshold, quality_threshold);
+    mRegisters.read(mReg.minRange, min_range);
+    mRegisters.read(mReg.maxRange, max_range);
+    mRegisters.read(mReg.qualityThreshold, quality_threshold);
 
     mSensor.setRange(min_range, max_range);
     mSensor.setQualityThreshold(quality_threshold);
@@ -136,14 +257,46 @@ void Sensor::update()
     if (ret == EXIT_FAILURE) {
         return;
     }
+
+    updateMeasureRate();
+    range = calibrate(range);
+
+    mLastMeasureTime = now;
+    mStatus = 0;
+    mRecoveryDelay = RECOVERY_MIN_DELAY;
+    uint8_t validity = classify(range, quality, quality_threshold);
+    mRegisters.writeRAM(mReg.validity, validity);
+    mRegisters.writeRAM(mReg.rawRange, rawRange);
+    mRegisters.writeRAM(mReg.quality, quality);
+    if (validity == VALIDITY_OUTLIER) {
+        if (mRejectCount < UINT16_MAX) {
+            mRejectCount++;
+        }
+        mRegisters.writeRAM(mReg.rejectCount, mRejectCount);
+        return;
+    }
+
+    uint16_t stats_window;
+    uint16_t stats_bin_width;
+    mRegisters.read(REG_STATS_WINDOW, stats_window);
+    mRegisters.read(REG_STATS_BIN_WIDTH, stats_bin_width);
+    mStatistics.add(range, quality, quality_threshold, stats_bin_width, stats_window);
+
     if (mMeasureCount < 254) {
         mMeasureCount++;
     }
-    mLastMeasureTime = now;
-    mRegisters.writeRAM(mRegMeasureCount, mMeasureCount);
-    mRegisters.writeRAM(mRegRange, (uint16_t)range);
-    mRegisters.writeRAM(mRegRawRange, rawRange);
-    mRegisters.writeRAM(mRegQuality, quality);
+    TRACE(TRACE_MEASURE, mIndex);
+    mRegisters.writeRAM(mReg.measureCount, mMeasureCount);
+    mRegisters.writeRAM(mReg.range, (uint16_t)range);
+    updateRangeRate(range, now);
+    mSample = range;
+    mSampleTime = now;
+    mNewSample = true;
+
+    if (mTriggered) {
+        mTriggerPending = false;
+        mSensor.stopMeasurement();
+    }
 
 #if DEBUG_MEASUREMENTS
     if (mErrorStream) {
@@ -153,8 +306,440 @@ void Sensor::update()
 #endif
 }
 
+uint32_t Sensor::idleTime(uint32_t now)
+{
+    if (mPowerStage == POWER_ON) {
+        return 0;
+    }
+    if (mPowerStage == POWER_WAIT) {
+        uint32_t elapsed = now - mPowerTime;
+        return elapsed >= mRecoveryDelay ? 0 : mRecoveryDelay - elapsed;
+    }
+    if (!mWired) {
+        return UINT32_MAX;
+    }
+
+    /* Measurement to start or to stop */
+    bool enabled;
+    mRegisters.read(mReg.enabled, enabled);
+    if (mTriggered) {
+        enabled = enabled && mTriggerPending;
+    }
+    if (enabled != mSensor.measurementStarted()) {
+        return 0;
+    }
+    if (!mSensor.measurementStarted()) {
+        return UINT32_MAX;
+    }
+
+    if (mMeasurementReady) {
+        return 0;
+    }
+    uint32_t elapsed = now - mLastMeasureTime;
+    if (mPolling) {
+        /* The sensor is polled continuously once the next measurement is
+         * expected, which is unknown without inter-measurement period */
+        return elapsed >= mPeriod ? 0 : mPeriod - elapsed;
+    }
+    uint32_t timeout = max(PERIOD_FAULT_TIMER * mPeriod, MINIMAL_FAULT_TIMER);
+    return elapsed > timeout ? 0 : timeout - elapsed + 1;
+}
+
+int Sensor::setConfig(uint8_t budget, uint8_t mode)
+{
+#if SENSOR_CONFIG_API
+    if (mSensor.setLongRange(mode == DISTANCE_MODE_LONG) != EXIT_SUCCESS ||
+            mSensor.setTimingBudget((uint32_t)budget * 1000) != EXIT_SUCCESS) {
+        mTimingBudget = 0;
+        return EXIT_FAILURE;
+    }
+#else
+    if (budget != RegisterStorage::defaultValue(mReg.timingBudget) ||
+            mode != RegisterStorage::defaultValue(mReg.distanceMode)) {
+        mTimingBudget = 0;
+        return EXIT_FAILURE;
+    }
+#endif
+    mTimingBudget = budget;
+    mDistanceMode = mode;
+    return EXIT_SUCCESS;
+}
+
+void Sensor::warmReset()
+{
+    mStatistics.reset();
+    mRecoveryCount = 0;
+    mRejectCount = 0;
+    mRegisters.writeRAM(mReg.recoveryCount, mRecoveryCount);
+    mRegisters.writeRAM(mReg.rejectCount, mRejectCount);
+    resetMeasureCount();
+}
+
 void Sensor::resetMeasureCount()
 {
     mMeasureCount = 0;
-    mRegisters.writeRAM(mRegMeasureCount, mMeasureCount);
+    mRegisters.writeRAM(mReg.measureCount, mMeasureCount);
+}
+
+/* The power on, at startup or after a fault, is split in several stages, each
+ * one being performed in a different call to update(), so that the other
+ * sensor and the communication with the master keep running during the
+ * standby and the backoff delay. The power on itself still blocks, see
+ * powerUp(). */
+void Sensor::startRecovery(uint32_t now)
+{
+    mStatus = (1 << mIndex);
+    TRACE(TRACE_SENSOR_FAULT, mIndex);
+    if (mErrorStream) {
+        mErrorStream->print("Sensor #");
+        mErrorStream->print(mIndex);
+        mErrorStream->println(" not responding.");
+    }
+    mSensor.standby();
+    mMeasurementReady = false;
+    mTriggerPending = false;
+    mReference = 0;
+    mRejectStreak = 0;
+    mRateStarted = false;
+    /* No stale collision alarm while the sensor recovers */
+    mLastRange = 0;
+    mRegisters.writeRAM(mReg.rangeRate, (int16_t)0);
+    mRegisters.writeRAM(mReg.timeToContact, (uint16_t)TIME_TO_CONTACT_NONE);
+    mPowerStage = POWER_WAIT;
+    mPowerTime = now;
+}
+
+void Sensor::powerUp(uint32_t now)
+{
+    switch (mPowerStage) {
+    case POWER_WAIT:
+        if (now - mPowerTime >= mRecoveryDelay) {
+            mPowerStage = POWER_ON;
+        }
+        break;
+    case POWER_ON:
+        /* powerON() of the ToF-Sensor library performs the whole VL53L0X
+         * initialization (boot, data and static init, reference calibration)
+         * in a single call, which cannot be split from here: this stage
+         * blocks the loop for tens of ms. Requests received meanwhile wait in
+         * the UART buffer and are answered late, and the other sensor misses
+         * its measurements. SensorMgr::update() powers on at most one sensor
+         * per update to bound the stall. */
+        if (mSensor.powerON(false) == EXIT_SUCCESS) {
+            TRACE(TRACE_POWER_ON, mIndex | 0x80);
+            /* The measurement will be started by the next update, and the
+             * error status cleared by the first valid measurement. The
+             * configuration of the sensor was lost. */
+            mPowerStage = POWER_IDLE;
+            mTimingBudget = 0;
+            if (mBooting) {
+                mWired = true;
+                uint8_t wiringStatus;
+                mRegisters.read(REG_WIRING_STATUS, wiringStatus);
+                wiringStatus |= (1 << mIndex);
+                mRegisters.writeRAM(REG_WIRING_STATUS, wiringStatus);
+                mRecoveryDelay = RECOVERY_MIN_DELAY;
+            }
+        }
+        else if (mBooting) {
+            TRACE(TRACE_POWER_ON, mIndex);
+            mPowerStage = POWER_IDLE;
+            if (mErrorStream) {
+                mErrorStream->print("Sensor #");
+                mErrorStream->print(mIndex);
+                mErrorStream->println(" not wired.");
+            }
+        }
+        else {
+            TRACE(TRACE_POWER_ON, mIndex);
+            mSensor.standby();
+            mRecoveryDelay = min(2 * mRecoveryDelay, RECOVERY_MAX_DELAY);
+            mPowerStage = POWER_WAIT;
+            mPowerTime = millis();
+        }
+
+        if (!mBooting && mRecoveryCount < 255) {
+            mRecoveryCount++;
+        }
+        mRegisters.writeRAM(mReg.recoveryCount, mRecoveryCount);
+        mBooting = false;
+        break;
+    default:
+        mPowerStage = POWER_IDLE;
+        break;
+    }
+}
+
+void Sensor::setTriggered(bool triggered)
+{
+    if (triggered != mTriggered) {
+        mTriggered = triggered;
+        mTriggerPending = false;
+        if (mSensor.measurementStarted()) {
+            mSensor.stopMeasurement();
+        }
+    }
+}
+
+bool Sensor::newSample(SensorValue &range, uint32_t &timestamp)
+{
+    if (!mNewSample) {
+        return false;
+    }
+    mNewSample = false;
+    range = mSample;
+    timestamp = mSampleTime;
+    return true;
+}
+
+uint32_t Sensor::configuredPeriod()
+{
+    bool adaptive;
+    mRegisters.read(mReg.adaptivePeriod, adaptive);
+    if (!adaptive) {
+        uint32_t period;
+        mRegisters.read(mReg.period, period);
+        return minimalPeriod(period);
+    }
+
+    uint16_t min_period;
+    uint16_t max_period;
+    mRegisters.read(mReg.minPeriod, min_period);
+    mRegisters.read(mReg.maxPeriod, max_period);
+    if (mAdaptivePeriod > max_period) {
+        mAdaptivePeriod = max_period;
+    }
+    if (mAdaptivePeriod < min_period) {
+        mAdaptivePeriod = min_period;
+    }
+    return minimalPeriod(mAdaptivePeriod);
+}
+
+uint32_t Sensor::minimalPeriod(uint32_t period)
+{
+    uint8_t budget = mTimingBudget;
+    if (budget == 0) {
+        mRegisters.read(mReg.timingBudget, budget);
+    }
+    if (period != 0 && period < (uint32_t)budget + TIMING_BUDGET_OVERHEAD) {
+        period = (uint32_t)budget + TIMING_BUDGET_OVERHEAD;
+    }
+    return period;
+}
+
+bool Sensor::configChanged()
+{
+    uint8_t budget;
+    uint8_t mode;
+    mRegisters.read(mReg.timingBudget, budget);
+    mRegisters.read(mReg.distanceMode, mode);
+    if (mTimingBudget != 0 && budget == mRejectedBudget && mode == mRejectedMode) {
+        /* Already refused, the sensor keeps the configuration in use */
+        return false;
+    }
+    return budget != mTimingBudget || mode != mDistanceMode;
+}
+
+int Sensor::applyConfig()
+{
+    uint8_t budget;
+    uint8_t mode;
+    mRegisters.read(mReg.timingBudget, budget);
+    mRegisters.read(mReg.distanceMode, mode);
+    mRejectedBudget = 0;
+    if (setConfig(budget, mode) != EXIT_SUCCESS) {
+        /* The sensor refused the configuration of the registers: it keeps
+         * the previous one, or the default one after a power on, so that the
+         * periods computed from the budget stay in step with the sensor. The
+         * sensor only faults if this one is refused too. */
+        TRACE(TRACE_CONFIG_REJECTED, mIndex);
+        if (mErrorStream) {
+            mErrorStream->print("Sensor #");
+            mErrorStream->print(mIndex);
+            mErrorStream->println(" configuration rejected.");
+        }
+        uint8_t previous_budget = mTimingBudget;
+        uint8_t previous_mode = mDistanceMode;
+        if (previous_budget == 0) {
+            previous_budget = RegisterStorage::defaultValue(mReg.timingBudget);
+            previous_mode = RegisterStorage::defaultValue(mReg.distanceMode);
+        }
+        if (setConfig(previous_budget, previous_mode) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        mRejectedBudget = budget;
+        mRejectedMode = mode;
+    }
+    mRateStarted = false;
+    mMeasureInterval = 0;
+    return EXIT_SUCCESS;
+}
+
+/* Achieved measurement rate, in mHz, from the filtered interval between two
+ * measurements */
+void Sensor::updateMeasureRate()
+{
+    uint32_t now = micros();
+    if (mRateStarted) {
+        uint32_t interval = now - mLastSampleTime;
+        if (mMeasureInterval == 0) {
+            mMeasureInterval = interval;
+        }
+        else {
+            mMeasureInterval = mMeasureInterval - mMeasureInterval / 4 + interval / 4;
+        }
+        uint32_t rate = 1000000000UL / max(mMeasureInterval, (uint32_t)1);
+        mRegisters.writeRAM(mReg.measureRate, (uint16_t)min(rate, UINT16_MAX));
+    }
+    mRateStarted = true;
+    mLastSampleTime = now;
+}
+
+void Sensor::updateRangeRate(SensorValue range, uint32_t now)
+{
+    if (range <= NO_OBSTACLE) {
+        mLastRange = 0;
+        mRegisters.writeRAM(mReg.rangeRate, (int16_t)0);
+        mRegisters.writeRAM(mReg.timeToContact,
+            (uint16_t)(range == OBSTACLE_TOO_CLOSE ? 0 : TIME_TO_CONTACT_NONE));
+        return;
+    }
+
+    updateVelocity(range, now);
+    if (mLastRange != 0 && now != mLastRangeTime) {
+        int32_t delta = abs((int32_t)range - (int32_t)mLastRange);
+        uint32_t rate = (uint32_t)max(delta - ADAPTIVE_NOISE, 0) * 1000 / (now - mLastRangeTime);
+        rate = min(rate, (uint32_t)UINT16_MAX / 4);
+        mActivity = (3 * (uint32_t)mActivity + rate) / 4;
+
+        /* Fast attack, slow release */
+        if (rate > ADAPTIVE_MOVING_RATE) {
+            mAdaptivePeriod /= 2;
+            mAdaptiveTime = now;
+        }
+        else if (mActivity < ADAPTIVE_STILL_RATE && now - mAdaptiveTime >= ADAPTIVE_HOLD_TIME) {
+            mAdaptivePeriod += max(mAdaptivePeriod / 4, ADAPTIVE_PERIOD_STEP);
+            mAdaptiveTime = now;
+        }
+    }
+    mLastRange = (uint16_t)range;
+    mLastRangeTime = now;
+}
+
+void Sensor::updateVelocity(SensorValue range, uint32_t now)
+{
+    uint32_t elapsed = now - mLastRangeTime;
+    int32_t measured = (int32_t)range << VELOCITY_SHIFT;
+    if (mLastRange != 0 && elapsed == 0) {
+        return;
+    }
+    if (mLastRange == 0 || elapsed > VELOCITY_MAX_GAP) {
+        mTrackRange = measured;
+        mVelocity = 0;
+    }
+    else {
+        int32_t predicted = mTrackRange + mVelocity * (int32_t)elapsed / 1000;
+        int32_t residual = measured - predicted;
+        mTrackRange = predicted + residual / VELOCITY_ALPHA_DIVIDER;
+        mVelocity += residual * 1000 / (int32_t)elapsed / VELOCITY_BETA_DIVIDER;
+        mVelocity = constrain(mVelocity, (int32_t)INT16_MIN * (1 << VELOCITY_SHIFT),
+            (int32_t)INT16_MAX * (1 << VELOCITY_SHIFT));
+    }
+
+    int32_t velocity = mVelocity / (1 << VELOCITY_SHIFT);
+    uint16_t time_to_contact = TIME_TO_CONTACT_NONE;
+    if (velocity < -VELOCITY_MIN_CLOSING) {
+        uint32_t time = (uint32_t)range * 1000 / (uint32_t)(-velocity);
+        time_to_contact = (uint16_t)min(time, (uint32_t)TIME_TO_CONTACT_NONE - 1);
+    }
+    mRegisters.writeRAM(mReg.rangeRate, (int16_t)velocity);
+    mRegisters.writeRAM(mReg.timeToContact, time_to_contact);
+}
+
+SensorValue Sensor::calibrate(SensorValue range)
+{
+    if (range <= NO_OBSTACLE) {
+        return range;
+    }
+
+    int16_t offset;
+    uint16_t gain;
+    mRegisters.read(mReg.calOffset, offset);
+    mRegisters.read(mReg.calGain, gain);
+
+    /* The points are read one at a time, up to the first one beyond range */
+    int32_t correction = 0;
+    uint16_t prev_range = 0;
+    int16_t prev_correction = 0;
+    for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) {
+        uint8_t point[4];
+        mRegisters.readEEPROMPage(mReg.calPage, 4 * i, 4, point);
+        uint16_t point_range = point[0] | ((uint16_t)point[1] << 8);
+        int16_t point_correction = point[2] | ((uint16_t)point[3] << 8);
+        if (point_range == 0) {
+            break;
+        }
+        if (range <= point_range) {
+            if (i == 0 || point_range <= prev_range) {
+                correction = point_correction;
+            }
+            else {
+                correction = prev_correction +
+                    ((int32_t)point_correction - prev_correction) *
+                    (range - prev_range) / (point_range - prev_range);
+            }
+            break;
+        }
+        prev_range = point_range;
+        prev_correction = point_correction;
+        correction = point_correction;
+    }
+
+    uint32_t corrected = constrain(range + correction, 0, UINT16_MAX);
+    int32_t calibrated = (int32_t)(corrected * gain / CALIBRATION_GAIN_ONE) + offset;
+    return constrain(calibrated, NO_OBSTACLE + 1, UINT16_MAX);
+}
+
+uint8_t Sensor::classify(SensorValue range, uint16_t quality, uint16_t qualityThreshold)
+{
+    if (range == OBSTACLE_TOO_CLOSE || range == NO_OBSTACLE) {
+        mReference = 0;
+        mRejectStreak = 0;
+        return range == NO_OBSTACLE ? VALIDITY_NO_OBSTACLE : VALIDITY_TOO_CLOSE;
+    }
+
+    uint16_t gate;
+    uint8_t confirm;
+    mRegisters.read(REG_OUTLIER_GATE, gate);
+    mRegisters.read(REG_OUTLIER_CONFIRM, confirm);
+    if (gate == 0) {
+        mReference = 0;
+        mRejectStreak = 0;
+        return VALIDITY_VALID;
+    }
+    if (qualityThreshold > 0) {
+        uint32_t q = constrain((uint32_t)quality, (uint32_t)qualityThreshold / 2,
+            2 * (uint32_t)qualityThreshold);
+        gate = max((uint32_t)gate * q / (2 * (uint32_t)qualityThreshold), (uint32_t)1);
+    }
+
+    if (mReference == 0 || (uint16_t)abs(range - (int32_t)mReference) <= gate) {
+        mReference = (uint16_t)range;
+        mRejectStreak = 0;
+        return VALIDITY_VALID;
+    }
+
+    if (mRejectStreak > 0 && (uint16_t)abs(range - (int32_t)mCandidate) <= gate) {
+        mRejectStreak++;
+    }
+    else {
+        mCandidate = (uint16_t)range;
+        mRejectStreak = 1;
+    }
+    if (mRejectStreak >= confirm) {
+        mReference = (uint16_t)range;
+        mRejectStreak = 0;
+        return VALIDITY_VALID;
+    }
+    return VALIDITY_OUTLIER;
 }
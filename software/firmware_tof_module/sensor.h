@@ -4,27 +4,97 @@
 #include <Arduino.h>
 #include <ToF_sensor.h>
 #include "register_storage.h"
+#include "statistics.h"
+
+
+/* Addresses of the registers used by one sensor */
+struct SensorRegisters
+{
+    uint8_t enabled;
+    uint8_t minRange;
+    uint8_t maxRange;
+    uint8_t qualityThreshold;
+    uint8_t period;
+    uint8_t polling;
+    uint8_t measureCount;
+    uint8_t range;
+    uint8_t rawRange;
+    uint8_t quality;
+    uint8_t adaptivePeriod;
+    uint8_t minPeriod;
+    uint8_t maxPeriod;
+    uint8_t currentPeriod;
+    uint8_t rangeRate;
+    uint8_t recoveryCount;
+    uint8_t calOffset;
+    uint8_t calGain;
+    uint8_t calPage; // EEPROM page of the calibration table
+    uint8_t validity;
+    uint8_t rejectCount;
+    uint8_t timingBudget;
+    uint8_t distanceMode;
+    uint8_t measureRate;
+    uint8_t timeToContact;
+};
 
 
 class Sensor
 {
 public:
+    enum PowerStage
+    {
+        POWER_IDLE,
+        POWER_WAIT, // sensor in standby, waiting before next power on
+        POWER_ON, // blocking initialization of the sensor
+    };
+
     Sensor(RegisterStorage &aRegisterStorage, uint8_t aIndex, uint8_t aAddress,
-        uint8_t aResetPin, uint8_t aRegEnabled, uint8_t aRegMinRange,
-        uint8_t aRegMaxRange, uint8_t aRegQualityThreshold, uint8_t aRegPeriod,
-        uint8_t aRegPolling, uint8_t aRegMeasureCount, uint8_t aRegRange,
-        uint8_t aRegRawRange, uint8_t aRegQuality, Stream *errStream = nullptr);
+        uint8_t aResetPin, const SensorRegisters &aRegisters,
+        Stream *errStream = nullptr);
 
+    /* The sensor is powered on by a later call to update() */
     void begin();
     void end();
     void update();
 
+    /* Time (ms) before update() has something to do, 0 if it has to be
+     * called right away, UINT32_MAX if nothing is expected */
+    uint32_t idleTime(uint32_t now);
+
     void resetMeasureCount();
     uint8_t status() const { return mStatus; }
     bool isWired() const { return mWired; }
+    bool poweringOn() const { return mPowerStage == POWER_ON; }
     void measurementReady() { mMeasurementReady = true; }
+    uint32_t configuredPeriod();
+
+    /* In triggered mode, the sensor only performs a single measurement each
+     * time trigger() is called, instead of measuring continuously */
+    void setTriggered(bool triggered);
+    /* Restart the statistics and the counters, the sensor keeps running */
+    void warmReset();
+    bool booting() const { return mBooting; }
+    void trigger() { mTriggerPending = true; }
+    bool busy() const { return mTriggerPending; }
+
+    const RangeStatistics &statistics() const { return mStatistics; }
+
+    /* Return true once for each new valid measurement published */
+    bool newSample(SensorValue &range, uint32_t &timestamp);
 
 private:
+    void startRecovery(uint32_t now);
+    void powerUp(uint32_t now);
+    void updateRangeRate(SensorValue range, uint32_t now);
+    void updateVelocity(SensorValue range, uint32_t now);
+    uint32_t minimalPeriod(uint32_t period);
+    bool configChanged();
+    int applyConfig();
+    int setConfig(uint8_t budget, uint8_t mode);
+    void updateMeasureRate();
+    SensorValue calibrate(SensorValue range);
+    uint8_t classify(SensorValue range, uint16_t quality, uint16_t qualityThreshold);
+
     RegisterStorage &mRegisters;
     ToF_longRange mSensor;
     uint8_t mStatus;
@@ -34,17 +104,43 @@ private:
     volatile bool mMeasurementReady;
     bool mPolling;
 
+    uint32_t mPeriod; // Inter-measurement period currently used by the sensor, in ms
+    uint8_t mTimingBudget; // Timing budget currently used by the sensor, in ms, 0 if unknown
+    uint8_t mDistanceMode;
+    uint8_t mRejectedBudget; // Configuration of the registers refused by the sensor, 0 if none
+    uint8_t mRejectedMode;
+    bool mRateStarted; // mLastSampleTime is valid
+    uint32_t mLastSampleTime; // us
+    uint32_t mMeasureInterval; // Filtered interval between two measurements, in us
+    uint32_t mAdaptivePeriod; // Period chosen by the adaptive mode, in ms
+    uint16_t mLastRange; // Last valid range, 0 if none
+    uint32_t mLastRangeTime;
+    uint16_t mActivity; // Filtered rate of change of the range, in mm/s
+    uint32_t mAdaptiveTime; // ms, last change of mAdaptivePeriod
+    int32_t mTrackRange; // Range estimated by the velocity filter, fixed point
+    int32_t mVelocity; // Velocity estimated by the velocity filter, fixed point
+
+    RangeStatistics mStatistics;
+
+    uint16_t mReference; // Last accepted range for the outlier gate, 0 if none
+    uint16_t mCandidate; // First range of the current run of rejected samples
+    uint8_t mRejectStreak;
+    uint16_t mRejectCount;
+
+    PowerStage mPowerStage;
+    bool mBooting; // true until the first power on attempt since begin()
+    uint32_t mPowerTime;
+    uint32_t mRecoveryDelay;
+    uint8_t mRecoveryCount;
+
+    bool mTriggered;
+    bool mTriggerPending;
+    bool mNewSample;
+    SensorValue mSample;
+    uint32_t mSampleTime;
+
     const uint8_t mIndex; // Sensor's index for r/w in bytes where each bit is reserved to a different sensor
-    const uint8_t mRegEnabled;
-    const uint8_t mRegMinRange;
-    const uint8_t mRegMaxRange;
-    const uint8_t mRegQualityThreshold;
-    const uint8_t mRegPeriod;
-    const uint8_t mRegPolling;
-    const uint8_t mRegMeasureCount;
-    const uint8_t mRegRange;
-    const uint8_t mRegRawRange;
-    const uint8_t mRegQuality;
+    const SensorRegisters &mReg;
 
     Stream *mErrorStream;
 };
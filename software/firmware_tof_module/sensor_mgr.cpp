@@ -5,18 +5,37 @@
 #define MAIN_SENSOR_PIN 4
 #define AUX_SENSOR_PIN 5
 
+static const SensorRegisters mainRegisters = {
+    REG_MAIN_ENABLED, REG_MAIN_MIN_RANGE, REG_MAIN_MAX_RANGE,
+    REG_MAIN_QUALITY_THRESHOLD, REG_MAIN_PERIOD, REG_MAIN_POLLING,
+    REG_MAIN_MCSLR, REG_MAIN_RANGE, REG_MAIN_RAW_RANGE, REG_MAIN_QUALITY,
+    REG_MAIN_ADAPTIVE_PERIOD, REG_MAIN_MIN_PERIOD, REG_MAIN_MAX_PERIOD,
+    REG_MAIN_CURRENT_PERIOD, REG_MAIN_RANGE_RATE, REG_MAIN_RECOVERY_COUNT,
+    REG_MAIN_CAL_OFFSET, REG_MAIN_CAL_GAIN, EEPROM_PAGE_MAIN_CALIBRATION,
+    REG_MAIN_VALIDITY, REG_MAIN_REJECT_COUNT, REG_MAIN_TIMING_BUDGET,
+    REG_MAIN_DISTANCE_MODE, REG_MAIN_MEASURE_RATE, REG_MAIN_TIME_TO_CONTACT
+};
 
-SensorMgr::SensorMgr(RegisterStorage &aRegisterStorage, Stream *errStream) :
+static const SensorRegisters auxRegisters = {
+    REG_AUX_ENABLED, REG_AUX_MIN_RANGE, REG_AUX_MAX_RANGE,
+    REG_AUX_QUALITY_THRESHOLD, REG_AUX_PERIOD, REG_AUX_POLLING,
+    REG_AUX_MCSLR, REG_AUX_RANGE, REG_AUX_RAW_RANGE, REG_AUX_QUALITY,
+    REG_AUX_ADAPTIVE_PERIOD, REG_AUX_MIN_PERIOD, REG_AUX_MAX_PERIOD,
+    REG_AUX_CURRENT_PERIOD, REG_AUX_RANGE_RATE, REG_AUX_RECOVERY_COUNT,
+    REG_AUX_CAL_OFFSET, REG_AUX_CAL_GAIN, EEPROM_PAGE_AUX_CALIBRATION,
+    REG_AUX_VALIDITY, REG_AUX_REJECT_COUNT, REG_AUX_TIMING_BUDGET,
+    REG_AUX_DISTANCE_MODE, REG_AUX_MEASURE_RATE, REG_AUX_TIME_TO_CONTACT
+};
+
+
+SensorMgr::SensorMgr(RegisterStorage &aRegisterStorage, const SyncClock &aClock,
+    Stream *errStream) :
+    mRegisters(aRegisterStorage),
+    mClock(aClock),
     mainSensor(aRegisterStorage, 0, MAIN_SENSOR_ADDR, MAIN_SENSOR_PIN,
-        REG_MAIN_ENABLED, REG_MAIN_MIN_RANGE, REG_MAIN_MAX_RANGE,
-        REG_MAIN_QUALITY_THRESHOLD, REG_MAIN_PERIOD, REG_MAIN_POLLING,
-        REG_MAIN_MCSLR, REG_MAIN_RANGE, REG_MAIN_RAW_RANGE, REG_MAIN_QUALITY,
-        errStream),
+        mainRegisters, errStream),
     auxSensor(aRegisterStorage, 1, AUX_SENSOR_ADDR, AUX_SENSOR_PIN,
-        REG_AUX_ENABLED, REG_AUX_MIN_RANGE, REG_AUX_MAX_RANGE,
-        REG_AUX_QUALITY_THRESHOLD, REG_AUX_PERIOD, REG_AUX_POLLING,
-        REG_AUX_MCSLR, REG_AUX_RANGE, REG_AUX_RAW_RANGE, REG_AUX_QUALITY,
-        errStream)
+        auxRegisters, errStream)
 {
     Wire.begin();
     end();
@@ -26,23 +45,135 @@ void SensorMgr::begin()
 {
     mainSensor.begin();
     auxSensor.begin();
+    /* The module answers while the sensors are powered on, the master waits
+     * for the end of the boot to read the wiring */
+    uint8_t wiringStatus;
+    mRegisters.read(REG_WIRING_STATUS, wiringStatus);
+    mRegisters.writeRAM(REG_WIRING_STATUS, (uint8_t)(wiringStatus | WIRING_BOOTING));
 }
 
 void SensorMgr::end()
 {
     mainSensor.end();
     auxSensor.end();
+    mLastTrigger = 0;
+    mNextIsAux = false;
+    mTriggerRequest = 0;
+    mTriggerBusy = 0;
+    mTriggerTime = 0;
+    mFrameRead = 0;
+    resetMergedMeasureCount();
+}
+
+void SensorMgr::warmReset()
+{
+    mainSensor.warmReset();
+    auxSensor.warmReset();
+    /* The sensors may still be measuring: the interleaved schedule restarts
+     * half a period later, with the main sensor */
+    mLastTrigger = millis();
+    mNextIsAux = false;
+    mTriggerRequest = 0;
+    mTriggerBusy = 0;
+    mRegisters.writeRAM(REG_TRIGGER, (uint8_t)0);
+    mFrameRead = 0;
+    resetMergedMeasureCount();
 }
 
 void SensorMgr::update()
 {
+    uint8_t mode;
+    bool external;
+    mRegisters.read(REG_INTERLEAVED_MODE, mode);
+    mRegisters.read(REG_EXTERNAL_TRIGGER, external);
+    if (!mainSensor.isWired() || !auxSensor.isWired() || external) {
+        mode = INTERLEAVED_OFF;
+    }
+    mainSensor.setTriggered(external || mode != INTERLEAVED_OFF);
+    auxSensor.setTriggered(external || mode != INTERLEAVED_OFF);
+    if (external) {
+        updateTrigger();
+    }
+    else if (mTriggerRequest || mTriggerBusy) {
+        mTriggerRequest = 0;
+        mTriggerBusy = 0;
+        mRegisters.writeRAM(REG_TRIGGER, (uint8_t)0);
+    }
+    if (mode != INTERLEAVED_OFF) {
+        schedule(mode);
+    }
+
+    /* Power on at most one sensor per update, so that the master keeps being
+     * served in between. The main sensor is always powered on first, which
+     * is required at startup since both sensors share the same default I2C
+     * address. */
+    bool mainPoweringOn = mainSensor.poweringOn();
     mainSensor.update();
-    auxSensor.update();
+    if (!mainPoweringOn) {
+        auxSensor.update();
+    }
+    uint8_t wiringStatus;
+    mRegisters.read(REG_WIRING_STATUS, wiringStatus);
+    if ((wiringStatus & WIRING_BOOTING) && !mainSensor.booting() && !auxSensor.booting()) {
+        mRegisters.writeRAM(REG_WIRING_STATUS, (uint8_t)(wiringStatus & ~WIRING_BOOTING));
+    }
+
+    /* The measurements of this update are published at once in the frame */
+    SensorValue range;
+    uint32_t timestamp;
+    uint8_t updated = 0;
+    if (mainSensor.newSample(range, timestamp)) {
+        updated |= FRAME_MAIN_UPDATED;
+        mRegisters.writeFrame(REG_FRAME_MAIN_RANGE, (uint16_t)range);
+        if (mode != INTERLEAVED_OFF) {
+            publishMerged(0, range, timestamp);
+        }
+    }
+    if (auxSensor.newSample(range, timestamp)) {
+        updated |= FRAME_AUX_UPDATED;
+        mRegisters.writeFrame(REG_FRAME_AUX_RANGE, (uint16_t)range);
+        if (mode != INTERLEAVED_OFF) {
+            publishMerged(1, range, timestamp);
+        }
+    }
+    if (updated) {
+        mRegisters.writeFrame(REG_FRAME_UPDATED, updated);
+        mRegisters.writeFrame(REG_FRAME_TIMESTAMP, (uint16_t)mClock.masterMillis());
+        mRegisters.publishFrame();
+    }
+}
+
+uint32_t SensorMgr::idleTime(uint32_t now)
+{
+    uint32_t idle = min(mainSensor.idleTime(now), auxSensor.idleTime(now));
+    uint8_t mode;
+    mRegisters.read(REG_INTERLEAVED_MODE, mode);
+    bool external;
+    mRegisters.read(REG_EXTERNAL_TRIGGER, external);
+    if (external) {
+        uint8_t delay;
+        mRegisters.read(REG_TRIGGER_DELAY, delay);
+        uint32_t elapsed = now - mTriggerTime;
+        if (mTriggerRequest) {
+            idle = min(idle, elapsed >= delay ? 0 : delay - elapsed);
+        }
+        if (completedTriggers()) {
+            idle = 0;
+        }
+    }
+    else if (mode != INTERLEAVED_OFF && mainSensor.isWired() && auxSensor.isWired()) {
+        uint32_t elapsed = now - mLastTrigger;
+        uint32_t half_period = mainSensor.configuredPeriod() / 2;
+        idle = min(idle, elapsed >= half_period ? 0 : half_period - elapsed);
+    }
+    return idle;
 }
 
 uint8_t SensorMgr::status() const
 {
-    return mainSensor.status() | auxSensor.status();
+    return mainSensor.status() | auxSensor.status() |
+        (newData() ? STATUS_NEW_DATA : 0) |
+        (collisionAlarm() ? STATUS_COLLISION_ALARM : 0);
 }
 
 void SensorMgr::resetMainMeasureCount()
@@ -55,6 +186,17 @@ void SensorMgr::resetAuxMeasureCount()
     auxSensor.resetMeasureCount();
 }
 
+void SensorMgr::resetMergedMeasureCount()
+{
+    mMergedCount = 0;
+    mRegisters.writeRAM(REG_MERGED_MCSLR, mMergedCount);
+}
+
+void SensorMgr::frameRead()
+{
+    mRegisters.read(REG_FRAME_SEQ, mFrameRead);
+}
+
 void SensorMgr::mainSensorReady()
 {
     mainSensor.measurementReady();
@@ -64,3 +206,127 @@ void SensorMgr::auxSensorReady()
 {
     auxSensor.measurementReady();
 }
+
+/* Trigger the sensors one after the other, every half period of the main
+ * sensor, so that each of them measures once per period */
+void SensorMgr::schedule(uint8_t mode)
+{
+    uint32_t now = millis();
+    if (now - mLastTrigger < mainSensor.configuredPeriod() / 2) {
+        return;
+    }
+
+    Sensor &next = mNextIsAux ? auxSensor : mainSensor;
+    Sensor &other = mNextIsAux ? mainSensor : auxSensor;
+    if (next.busy() || (mode == INTERLEAVED_ALTERNATE && other.busy())) {
+        return;
+    }
+    next.trigger();
+    mLastTrigger = now;
+    mNextIsAux = !mNextIsAux;
+}
+
+void SensorMgr::trigger()
+{
+    mRegisters.read(REG_TRIGGER, mTriggerRequest);
+    mTriggerBusy = 0;
+    mTriggerTime = millis();
+}
+
+/* External trigger: the sensors set in REG_TRIGGER perform a single
+ * measurement, started REG_TRIGGER_DELAY ms after the request so that the
+ * modules of a bus can be given different slots. The bits of REG_TRIGGER are
+ * cleared once the measurements are published in the frame. Sensors not
+ * wired or faulty complete at once, without measurement. */
+void SensorMgr::updateTrigger()
+{
+    if (mTriggerRequest) {
+        uint8_t delay;
+        mRegisters.read(REG_TRIGGER_DELAY, delay);
+        if (millis() - mTriggerTime >= delay) {
+            if ((mTriggerRequest & TRIGGER_MAIN) && mainSensor.isWired() && mainSensor.status() == 0) {
+                mainSensor.trigger();
+                mTriggerBusy |= TRIGGER_MAIN;
+            }
+            if ((mTriggerRequest & TRIGGER_AUX) && auxSensor.isWired() && auxSensor.status() == 0) {
+                auxSensor.trigger();
+                mTriggerBusy |= TRIGGER_AUX;
+            }
+            mTriggerRequest = 0;
+        }
+    }
+    mTriggerBusy &= ~completedTriggers();
+    mRegisters.writeRAM(REG_TRIGGER, (uint8_t)(mTriggerRequest | mTriggerBusy));
+}
+
+uint8_t SensorMgr::completedTriggers()
+{
+    uint8_t completed = 0;
+    if ((mTriggerBusy & TRIGGER_MAIN) && !mainSensor.busy()) {
+        completed |= TRIGGER_MAIN;
+    }
+    if ((mTriggerBusy & TRIGGER_AUX) && !auxSensor.busy()) {
+        completed |= TRIGGER_AUX;
+    }
+    return completed;
+}
+
+void SensorMgr::publishMerged(uint8_t source, SensorValue range, uint32_t timestamp)
+{
+    if (range > NO_OBSTACLE) {
+        int16_t offset;
+        mRegisters.read(source == 0 ? REG_MAIN_OFFSET : REG_AUX_OFFSET, offset);
+        range = constrain(range + offset, NO_OBSTACLE + 1, UINT16_MAX);
+    }
+    if (mMergedCount < 254) {
+        mMergedCount++;
+    }
+    mRegisters.writeRAM(REG_MERGED_MCSLR, mMergedCount);
+    mRegisters.writeRAM(REG_MERGED_RANGE, (uint16_t)range);
+    uint32_t age = millis() - timestamp;
+    mRegisters.writeRAM(REG_MERGED_TIMESTAMP, (uint16_t)(mClock.masterMillis() - age));
+    mRegisters.writeRAM(REG_MERGED_SOURCE, source);
+}
+
+bool SensorMgr::newData() const
+{
+    uint8_t sources;
+    uint8_t value;
+    mRegisters.read(REG_NEW_DATA_SOURCES, sources);
+    if (sources & NEW_DATA_MAIN) {
+        mRegisters.read(REG_MAIN_MCSLR, value);
+        if (value > 0) {
+            return true;
+        }
+    }
+    if (sources & NEW_DATA_AUX) {
+        mRegisters.read(REG_AUX_MCSLR, value);
+        if (value > 0) {
+            return true;
+        }
+    }
+    if (sources & NEW_DATA_MERGED) {
+        mRegisters.read(REG_MERGED_MCSLR, value);
+        if (value > 0) {
+            return true;
+        }
+    }
+    if (sources & NEW_DATA_FRAME) {
+        mRegisters.read(REG_FRAME_SEQ, value);
+        if (value != mFrameRead) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SensorMgr::collisionAlarm() const
+{
+    uint16_t threshold;
+    uint16_t main_ttc;
+    uint16_t aux_ttc;
+    mRegisters.read(REG_COLLISION_ALARM, threshold);
+    mRegisters.read(REG_MAIN_TIME_TO_CONTACT, main_ttc);
+    mRegisters.read(REG_AUX_TIME_TO_CONTACT, aux_ttc);
+    return main_ttc < threshold || aux_ttc < threshold;
+}
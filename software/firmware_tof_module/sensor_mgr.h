@@ -5,29 +5,82 @@
 #include <Wire.h>
 #include "sensor.h"
 #include "register_storage.h"
+#include "sync_clock.h"
 
 #define MAIN_SENSOR_INT_PIN 2
 #define AUX_SENSOR_INT_PIN 3
+#define STATUS_NEW_DATA 32 // bit of the hardware status, see SensorMgr::status()
+#define STATUS_COLLISION_ALARM 128 // bit of the hardware status, see SensorMgr::status()
+
+enum InterleavedMode
+{
+    INTERLEAVED_OFF = 0,
+    INTERLEAVED_HALF_PERIOD = 1, // aux sensor measures half a period after main sensor
+    INTERLEAVED_ALTERNATE = 2, // sensors never measure at the same time
+};
 
 
 class SensorMgr
 {
 public:
-    SensorMgr(RegisterStorage &aRegisterStorage,
+    SensorMgr(RegisterStorage &aRegisterStorage, const SyncClock &aClock,
         Stream *errStream = nullptr);
 
     void begin();
     void end();
+    /* Restart the statistics, the counters and the trigger schedules, the
+     * sensors keep running */
+    void warmReset();
     void update();
+
+    /* Time (ms) before update() has something to do, see Sensor::idleTime() */
+    uint32_t idleTime(uint32_t now);
+
+    /* Hardware status sent in every reply: the errors of the sensors, and
+     * STATUS_NEW_DATA while one of the sources selected in
+     * REG_NEW_DATA_SOURCES has data not read yet by the master, which can
+     * then poll with a status-only ping and skip the reads of stale data.
+     * Both bits read as errors to a generic master, so no source is selected
+     * and the alarm is disabled by default.
+     * STATUS_COLLISION_ALARM is set while the time to contact of a sensor
+     * is below REG_COLLISION_ALARM (ms, 0 to disable). */
     uint8_t status() const;
     void resetMainMeasureCount();
     void resetAuxMeasureCount();
+    void resetMergedMeasureCount();
+    void frameRead(); // to call when REG_FRAME_SEQ is read
+    const RangeStatistics &mainStatistics() const { return mainSensor.statistics(); }
+    const RangeStatistics &auxStatistics() const { return auxSensor.statistics(); }
     void mainSensorReady();
     void auxSensorReady();
 
+    /* External trigger: to call when REG_TRIGGER is written */
+    void trigger();
+
 private:
+    void schedule(uint8_t mode);
+    void updateTrigger();
+    uint8_t completedTriggers();
+    void publishMerged(uint8_t source, SensorValue range, uint32_t timestamp);
+    bool newData() const;
+    bool collisionAlarm() const;
+
+    RegisterStorage &mRegisters;
+    const SyncClock &mClock; // time base of the published timestamps
     Sensor mainSensor;
     Sensor auxSensor;
+
+    /* Interleaved mode */
+    uint32_t mLastTrigger;
+    bool mNextIsAux;
+    uint8_t mMergedCount;
+
+    uint8_t mFrameRead; // sequence of the last frame read by the master
+
+    /* External trigger */
+    uint8_t mTriggerRequest; // sensors to trigger once the delay elapsed
+    uint8_t mTriggerBusy; // sensors measuring since the trigger
+    uint32_t mTriggerTime;
 };
 
 
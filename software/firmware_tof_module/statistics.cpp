@@ -0,0 +1,168 @@
+#include "statistics.h"
+
+/* The variance is computed with Welford's method: each sample adds the
+ * product of its deviations from the previous and the updated mean to the
+ * sum of the squared deviations, instead of accumulating the squares, so
+ * that 32 bits are enough. The deviations are computed with STATISTICS_SHIFT
+ * fractional bits, on ranges limited to STATISTICS_MAX_RANGE, the limit of
+ * the VL53L0X, so that their product fits in 32 bits. The sum is scaled down
+ * by powers of two when it would overflow, for windows of large variance. */
+#define STATISTICS_SHIFT 4 // 1/16 mm
+#define STATISTICS_MAX_RANGE 8191 // mm
+
+
+static uint8_t fraction(uint16_t value, uint16_t total)
+{
+    if (total == 0) {
+        return 0;
+    }
+    return (uint8_t)min(((uint32_t)value << 8) / total, 255);
+}
+
+/* Mean of the valid ranges, in 1/16 mm */
+static int32_t mean_of(uint32_t sum, uint16_t count)
+{
+    return (int32_t)(((sum / count) << STATISTICS_SHIFT) +
+        ((sum % count) << STATISTICS_SHIFT) / count);
+}
+
+/* Deviation from 1/16 mm to 1/4 mm, rounded, so that the product of two
+ * deviations is below 2^30 */
+static int32_t quarter(int32_t deviation)
+{
+    return (deviation >= 0 ? deviation + 2 : deviation - 2) / 4;
+}
+
+static void write16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+RangeStatistics::RangeStatistics()
+{
+    reset();
+}
+
+void RangeStatistics::reset()
+{
+    restart();
+    memset(mPublished, 0, STATS_SIZE);
+}
+
+void RangeStatistics::restart()
+{
+    mCount = 0;
+    mValidCount = 0;
+    mMin = UINT16_MAX;
+    mMax = 0;
+    mSum = 0;
+    mSquares = 0;
+    mSquaresShift = 0;
+    mSquaresCarry = 0;
+    memset(mRangeBins, 0, sizeof(mRangeBins));
+    memset(mQualityBins, 0, sizeof(mQualityBins));
+    mTooClose = 0;
+    mNoObstacle = 0;
+}
+
+void RangeStatistics::add(SensorValue range, uint16_t quality,
+    uint16_t qualityThreshold, uint16_t binWidth, uint16_t windowSize)
+{
+    if (mCount == UINT16_MAX) {
+        restart();
+    }
+    mCount++;
+
+    if (range == OBSTACLE_TOO_CLOSE) {
+        mTooClose++;
+    }
+    else if (range == NO_OBSTACLE) {
+        mNoObstacle++;
+    }
+    else if (range > NO_OBSTACLE) {
+        uint16_t value = (uint16_t)range;
+        mValidCount++;
+        mMin = min(mMin, value);
+        mMax = max(mMax, value);
+        addSquares(min(value, STATISTICS_MAX_RANGE));
+        uint16_t bin = binWidth > 0 ? value / binWidth : 0;
+        mRangeBins[min(bin, STATISTICS_RANGE_BINS - 1)]++;
+    }
+
+    uint8_t quality_bin;
+    if (quality < qualityThreshold / 2) {
+        quality_bin = 0;
+    }
+    else if (quality < qualityThreshold) {
+        quality_bin = 1;
+    }
+    else if (quality < 2 * (uint32_t)qualityThreshold) {
+        quality_bin = 2;
+    }
+    else {
+        quality_bin = 3;
+    }
+    mQualityBins[quality_bin]++;
+
+    if (windowSize == 0) {
+        publish();
+    }
+    else if (mCount >= windowSize) {
+        publish();
+        restart();
+    }
+}
+
+void RangeStatistics::addSquares(uint16_t value)
+{
+    int32_t scaled = (int32_t)value << STATISTICS_SHIFT;
+    int32_t previous = mValidCount > 1 ? mean_of(mSum, mValidCount - 1) : scaled;
+    mSum += value;
+    int32_t mean = mean_of(mSum, mValidCount);
+
+    /* 1/16 mm^2, below 2^30 + 2^12 */
+    int32_t total = quarter(scaled - previous) * quarter(scaled - mean) + mSquaresCarry;
+    uint8_t bits = STATISTICS_SHIFT + mSquaresShift;
+    while (total >> bits > 0 && mSquares > UINT32_MAX - (uint32_t)(total >> bits)) {
+        total += (int32_t)(mSquares & 1) << bits;
+        mSquares >>= 1;
+        mSquaresShift++;
+        bits++;
+    }
+    int32_t squares = total >> bits;
+    mSquaresCarry = (uint16_t)(total - (squares << bits));
+    if (squares >= 0) {
+        mSquares += squares;
+    }
+    else {
+        /* Rounding of the deviations only */
+        mSquares = mSquares > (uint32_t)-squares ? mSquares + squares : 0;
+    }
+}
+
+void RangeStatistics::publish()
+{
+    uint16_t mean = 0;
+    uint32_t variance = 0;
+    if (mValidCount > 0) {
+        mean = (mean_of(mSum, mValidCount) + (1 << (STATISTICS_SHIFT - 1))) >> STATISTICS_SHIFT;
+        variance = ((mSquares / mValidCount) << mSquaresShift) +
+            (((mSquares % mValidCount) << mSquaresShift) + mValidCount / 2) / mValidCount;
+    }
+
+    write16(mPublished + STATS_COUNT, mCount);
+    write16(mPublished + STATS_MIN, mValidCount > 0 ? mMin : 0);
+    write16(mPublished + STATS_MAX, mMax);
+    write16(mPublished + STATS_MEAN, mean);
+    write16(mPublished + STATS_VARIANCE, (uint16_t)variance);
+    write16(mPublished + STATS_VARIANCE + 2, (uint16_t)(variance >> 16));
+    for (uint8_t i = 0; i < STATISTICS_RANGE_BINS; i++) {
+        mPublished[STATS_RANGE_HISTOGRAM + i] = fraction(mRangeBins[i], mCount);
+    }
+    for (uint8_t i = 0; i < STATISTICS_QUALITY_BINS; i++) {
+        mPublished[STATS_QUALITY_HISTOGRAM + i] = fraction(mQualityBins[i], mCount);
+    }
+    mPublished[STATS_TOO_CLOSE] = fraction(mTooClose, mCount);
+    mPublished[STATS_NO_OBSTACLE] = fraction(mNoObstacle, mCount);
+}
@@ -0,0 +1,70 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <Arduino.h>
+#include <ToF_sensor.h>
+
+#define STATISTICS_RANGE_BINS 8
+#define STATISTICS_QUALITY_BINS 4
+
+/* Layout of the published statistics, as read in the page window */
+enum StatisticsLayout
+{
+    STATS_COUNT = 0, // uint16, number of samples
+    STATS_MIN = 2, // uint16, mm
+    STATS_MAX = 4, // uint16, mm
+    STATS_MEAN = 6, // uint16, mm
+    STATS_VARIANCE = 8, // uint32, mm^2
+    STATS_RANGE_HISTOGRAM = 12, // uint8[8], fraction of samples in 1/256
+    STATS_QUALITY_HISTOGRAM = 20, // uint8[4], fraction of samples in 1/256
+    STATS_TOO_CLOSE = 24, // uint8, fraction of samples in 1/256
+    STATS_NO_OBSTACLE = 25, // uint8, fraction of samples in 1/256
+    STATS_SIZE = 26
+};
+
+
+/* Statistics of the measurements of one sensor, accumulated over a window
+ * of samples. Min, max, mean and variance are computed on valid ranges only.
+ * The range histogram has bins of configurable width, the last one being
+ * unbounded. The quality bins are relative to the quality threshold T:
+ * [0, T/2[, [T/2, T[, [T, 2T[, [2T, +inf[
+ */
+class RangeStatistics
+{
+public:
+    RangeStatistics();
+
+    /* Clear the published statistics and restart the accumulation */
+    void reset();
+
+    /* Add a sample. Once windowSize samples have been added, the statistics
+     * are published and the accumulation restarts. A windowSize of zero
+     * means no window: the statistics are published after each sample. */
+    void add(SensorValue range, uint16_t quality, uint16_t qualityThreshold,
+        uint16_t binWidth, uint16_t windowSize);
+
+    const uint8_t *published() const { return mPublished; }
+
+private:
+    void restart();
+    void addSquares(uint16_t value);
+    void publish();
+
+    uint16_t mCount;
+    uint16_t mValidCount;
+    uint16_t mMin;
+    uint16_t mMax;
+    uint32_t mSum;
+    uint32_t mSquares; // sum of the squared deviations, in mm^2 << mSquaresShift
+    uint8_t mSquaresShift;
+    uint16_t mSquaresCarry; // 1/16 mm^2, remainder of mSquares
+    uint16_t mRangeBins[STATISTICS_RANGE_BINS];
+    uint16_t mQualityBins[STATISTICS_QUALITY_BINS];
+    uint16_t mTooClose;
+    uint16_t mNoObstacle;
+
+    uint8_t mPublished[STATS_SIZE];
+};
+
+
+#endif
@@ -0,0 +1,122 @@
+#include "sync_clock.h"
+
+/* At each synchronization, the error between the received master time and
+ * the one predicted from the previous synchronization is measured. The
+ * prediction is then anchored on the received time, and the drift corrected
+ * by a fraction of the error:
+ * DRIFT += ERROR / INTERVAL / SYNC_DRIFT_GAIN
+ * The drift is only updated once the messages span SYNC_MIN_INTERVAL, the
+ * errors of closer messages being accumulated, and the estimation restarts
+ * if the error exceeds SYNC_MAX_ERROR, e.g. after a restart of the master.
+ * The time of a message is the time it is handled, not its reception: a
+ * message which may have waited more than SYNC_MAX_LATENCY, e.g. behind the
+ * power on of a sensor, is dropped.
+ *
+ * Between synchronizations, update() re-anchors the prediction every
+ * SYNC_ANCHOR_INTERVAL, so that the elapsed time stays below
+ * SYNC_MAX_ELAPSED and the drift correction fits in 32 bits.
+ */
+#define SYNC_DRIFT_GAIN 4
+#define SYNC_MIN_INTERVAL 100000 // us
+#define SYNC_MAX_INTERVAL 1800000000 // us, drift updates over longer intervals are dropped
+#define SYNC_MAX_ERROR 100000 // us
+#define SYNC_MAX_DRIFT 32767 // ppm, beyond the tolerance of the UART, and the range of REG_SYNC_DRIFT
+#define SYNC_MAX_LATENCY 2000 // us
+#define SYNC_ANCHOR_INTERVAL 4000000 // us
+#define SYNC_MAX_ELAPSED 8388607 // us, (2^23 - 1) * SYNC_MAX_DRIFT in 2^-18 units fits in 32 bits
+
+
+SyncClock::SyncClock(RegisterStorage &aRegisterStorage) :
+    mRegisters(aRegisterStorage)
+{
+    mCount = 0;
+    mLocalRef = 0;
+    mMasterRef = 0;
+    mDrift = 0;
+    mDriftFactor = 0;
+    mDriftRef = 0;
+    mDriftError = 0;
+}
+
+void SyncClock::reset()
+{
+    mCount = 0;
+    mLocalRef = 0;
+    mMasterRef = 0;
+    mDrift = 0;
+    mDriftFactor = 0;
+    mDriftRef = 0;
+    mDriftError = 0;
+    mRegisters.writeRAM(REG_SYNC_ERROR, (int16_t)0);
+    mRegisters.writeRAM(REG_SYNC_DRIFT, (int16_t)0);
+    mRegisters.writeRAM(REG_SYNC_COUNT, mCount);
+}
+
+void SyncClock::synchronize(uint32_t localTime, uint32_t latency)
+{
+    if (latency > SYNC_MAX_LATENCY) {
+        return;
+    }
+
+    uint32_t master_time;
+    mRegisters.read(REG_SYNC_TIME, master_time);
+    int32_t error = (int32_t)(master_time - masterMicros(localTime));
+
+    if (mCount == 0 || abs(error) > SYNC_MAX_ERROR) {
+        mCount = 0;
+        mDrift = 0;
+        mDriftFactor = 0;
+        mDriftRef = localTime;
+        mDriftError = 0;
+        error = 0;
+    }
+    else {
+        /* Messages too close to the previous drift update only re-anchor the
+         * time, their error is used by the next drift update */
+        mDriftError += error;
+        uint32_t interval = localTime - mDriftRef;
+        if (interval >= SYNC_MIN_INTERVAL) {
+            /* 64-bit division, once per drift update only */
+            int32_t correction = (int64_t)mDriftError * 1000000 / interval / SYNC_DRIFT_GAIN;
+            mDrift = constrain(mDrift + correction, -SYNC_MAX_DRIFT, SYNC_MAX_DRIFT);
+            mDriftFactor = mDrift * 4096 / 15625; // * 2^18 / 10^6
+            mDriftRef = localTime;
+            mDriftError = 0;
+        }
+    }
+
+    mLocalRef = localTime;
+    mMasterRef = master_time;
+    if (mCount < 255) {
+        mCount++;
+    }
+    mRegisters.writeRAM(REG_SYNC_ERROR, (int16_t)constrain(error, INT16_MIN, INT16_MAX));
+    mRegisters.writeRAM(REG_SYNC_DRIFT, (int16_t)mDrift);
+    mRegisters.writeRAM(REG_SYNC_COUNT, mCount);
+}
+
+void SyncClock::update(uint32_t localTime)
+{
+    if (mCount == 0) {
+        return;
+    }
+    if (localTime - mLocalRef >= SYNC_ANCHOR_INTERVAL) {
+        mMasterRef = masterMicros(localTime);
+        mLocalRef = localTime;
+    }
+    if (localTime - mDriftRef >= SYNC_MAX_INTERVAL) {
+        /* The master stopped synchronizing, the drift is kept */
+        mDriftRef = localTime;
+        mDriftError = 0;
+    }
+}
+
+uint32_t SyncClock::masterMicros(uint32_t localTime) const
+{
+    if (mCount == 0) {
+        return localTime;
+    }
+    /* Bounded by update(), the constraint only guards the 32-bit product */
+    int32_t elapsed = constrain((int32_t)(localTime - mLocalRef), -SYNC_MAX_ELAPSED, SYNC_MAX_ELAPSED);
+    return mMasterRef + elapsed + (elapsed / 64 * mDriftFactor) / 4096;
+}
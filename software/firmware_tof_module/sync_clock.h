@@ -0,0 +1,46 @@
+#ifndef SYNC_CLOCK_H
+#define SYNC_CLOCK_H
+
+#include <Arduino.h>
+#include "register_storage.h"
+
+
+/* Time base of the master, estimated from the synchronization messages: the
+ * master periodically broadcasts its time (us) in REG_SYNC_TIME, and the
+ * offset and drift of the local clock are estimated from the successive
+ * messages. Until the first message, the master time is the local time. */
+class SyncClock
+{
+public:
+    SyncClock(RegisterStorage &aRegisterStorage);
+
+    /* Back to the local time, until the next synchronization */
+    void reset();
+
+    /* To call when REG_SYNC_TIME is written, with the local time of the
+     * reception and the bound of its latency, the time the message may have
+     * waited before being handled. Messages handled too late are dropped. */
+    void synchronize(uint32_t localTime, uint32_t latency);
+
+    /* To call periodically from the main loop, at least every few seconds:
+     * moves the reference forward so that the master time never has to be
+     * extrapolated over a long interval */
+    void update(uint32_t localTime);
+
+    /* Master time (us) at the given local time (us, micros()) */
+    uint32_t masterMicros(uint32_t localTime) const;
+    uint32_t masterMillis() const { return masterMicros(micros()) / 1000; }
+
+private:
+    RegisterStorage &mRegisters;
+    uint8_t mCount; // number of synchronizations, 0 if not synchronized
+    uint32_t mLocalRef; // us, local time of the last synchronization
+    uint32_t mMasterRef; // us, master time of the last synchronization
+    int32_t mDrift; // ppm, rate of the master clock relative to the local clock, minus one
+    int32_t mDriftFactor; // mDrift in 2^-18 units, see masterMicros()
+    uint32_t mDriftRef; // us, local time of the last drift update
+    int32_t mDriftError; // us, error accumulated since the last drift update
+};
+
+
+#endif
@@ -0,0 +1,63 @@
+#include "trace.h"
+#include <util/atomic.h>
+
+Trace trace;
+
+
+Trace::Trace()
+{
+    mHead = 0;
+    mTail = 0;
+    mLost = 0;
+}
+
+void Trace::log(uint8_t event, uint8_t arg)
+{
+    uint16_t time = (uint16_t)(micros() >> TRACE_TIME_SHIFT);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint8_t free_records = TRACE_BUFFER_SIZE - (uint8_t)(mHead - mTail);
+        if (mLost > 0 && free_records >= 2) {
+            uint8_t *record = mBuffer[mHead % TRACE_BUFFER_SIZE];
+            record[0] = TRACE_OVERFLOW;
+            record[1] = mLost;
+            record[2] = (uint8_t)time;
+            record[3] = (uint8_t)(time >> 8);
+            mHead++;
+            mLost = 0;
+            free_records--;
+        }
+        if (mLost > 0 || free_records == 0) {
+            if (mLost < 255) {
+                mLost++;
+            }
+        }
+        else {
+            uint8_t *record = mBuffer[mHead % TRACE_BUFFER_SIZE];
+            record[0] = event;
+            record[1] = arg;
+            record[2] = (uint8_t)time;
+            record[3] = (uint8_t)(time >> 8);
+            mHead++;
+        }
+    }
+}
+
+uint8_t Trace::available() const
+{
+    return (uint8_t)(mHead - mTail);
+}
+
+uint8_t Trace::pop(uint8_t *data, uint8_t size)
+{
+    uint8_t count = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        while (mTail != mHead && (uint8_t)(count + 1) * TRACE_RECORD_SIZE <= size) {
+            memcpy(data + count * TRACE_RECORD_SIZE,
+                mBuffer[mTail % TRACE_BUFFER_SIZE], TRACE_RECORD_SIZE);
+            mTail++;
+            count++;
+        }
+    }
+    memset(data + count * TRACE_RECORD_SIZE, 0, size - count * TRACE_RECORD_SIZE);
+    return count;
+}
@@ -0,0 +1,64 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+#define TRACE_ENABLED 1
+#define TRACE_BUFFER_SIZE 32 // records, must be a power of 2
+#define TRACE_RECORD_SIZE 4 // bytes
+#define TRACE_TIME_SHIFT 4 // time unit is 2^TRACE_TIME_SHIFT us
+#define TRACE_SYNC_BYTE 0xA5 // precedes each record sent on the debug serial
+
+/* Keep in sync with software/tools/trace_decoder.py */
+enum TraceEvent
+{
+    TRACE_NONE = 0,
+    TRACE_OVERFLOW = 1, // arg: number of records lost (saturated)
+    TRACE_START = 2, // arg: 1 if warm start
+    TRACE_SOFT_RESET = 3,
+    TRACE_FACTORY_RESET = 4,
+    TRACE_READ = 5, // arg: address
+    TRACE_WRITE = 6, // arg: address
+    TRACE_SENSOR_READY = 7, // arg: sensor index
+    TRACE_MEASURE = 8, // arg: sensor index
+    TRACE_SENSOR_FAULT = 9, // arg: sensor index
+    TRACE_POWER_ON = 10, // arg: sensor index, bit 7 set on success
+    TRACE_VCC = 11, // arg: input voltage register
+    TRACE_BAUDRATE = 12, // arg: baudrate register
+    TRACE_CONFIG_REJECTED = 13, // arg: sensor index
+};
+
+
+/* Ring buffer of compact binary records: event id, argument and 16 bits time
+ * stamp. Logging is cheap enough to be done from an ISR, and the records are
+ * read later, either by the master or on the debug serial when idle.
+ */
+class Trace
+{
+public:
+    Trace();
+
+    void log(uint8_t event, uint8_t arg = 0);
+    uint8_t available() const;
+
+    /* Move up to size / TRACE_RECORD_SIZE records to data, the remaining
+     * bytes are zeroed. Return the number of records moved. */
+    uint8_t pop(uint8_t *data, uint8_t size);
+
+private:
+    uint8_t mBuffer[TRACE_BUFFER_SIZE][TRACE_RECORD_SIZE];
+    volatile uint8_t mHead;
+    volatile uint8_t mTail;
+    volatile uint8_t mLost;
+};
+
+extern Trace trace;
+
+#if TRACE_ENABLED
+#define TRACE(event, arg) trace.log(event, arg)
+#else
+#define TRACE(event, arg)
+#endif
+
+
+#endif
@@ -8,12 +8,16 @@
 #define PIN_DEBUG_C 8
 #define PIN_DEBUG_D 9
 
-static long read_vcc()
+static inline long read_vcc()
 {
 #ifdef __AVR_ATmega328P__
     long result; // Read 1.1V reference against AVcc
-    ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
-    delay(2); // Wait for Vref to settle
+    uint8_t admux = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+    if (ADMUX != admux) {
+        /* The ADC is only used here, the reference stays selected */
+        ADMUX = admux;
+        delay(2); // Wait for Vref to settle
+    }
     ADCSRA |= _BV(ADSC); // Convert
     while (bit_is_set(ADCSRA, ADSC));
     result = ADCL;
@@ -25,30 +29,43 @@ static long read_vcc()
 #endif
 }
 
-static int free_ram()
+static inline int free_ram()
 {
+#ifdef __AVR__
     extern int __heap_start, *__brkval;
     int v;
     return (int)&v - (__brkval == 0 ? (int)&__heap_start : (int)__brkval);
+#else
+    return 0;
+#endif
 }
 
-static bool check_buffer_intersect(size_t b1_start, size_t b1_size,
-    size_t b2_start, size_t b2_size)
+/* Maximal error allowed between the requested and the actual baudrate */
+#define BAUDRATE_TOLERANCE 20 // per thousand
+/* Highest REG_BAUDRATE value, 9600 baud */
+#define BAUDRATE_MAX_VALUE 207
+
+static inline uint32_t baudrate(uint8_t stored_baudrate)
 {
-    if (b1_start < b2_start) {
-        return b1_start + b1_size > b2_start;
-    }
-    else if (b1_start > b2_start) {
-        return b1_start < b2_start + b2_size;
-    }
-    else {
-        return b1_size > 0 && b2_size > 0;
-    }
+    return 2000000 / ((uint32_t)stored_baudrate + 1);
 }
 
-static uint32_t baudrate(uint8_t stored_baudrate)
+/* Actual baudrate of the UART, as configured by HardwareSerial::begin() in
+ * double speed mode: UBRR = round(F_CPU / (8 * baudrate)) - 1 */
+static inline uint32_t real_baudrate(uint8_t stored_baudrate)
 {
-    return 2000000 / ((uint32_t)stored_baudrate + 1);
+    uint32_t ubrr = (F_CPU / 4 / baudrate(stored_baudrate) - 1) / 2;
+    return F_CPU / 8 / (ubrr + 1);
+}
+
+/* Some baudrates cannot be generated accurately from F_CPU, e.g. 2000000/3
+ * falls back to 500000 at 8 MHz */
+static inline bool baudrate_accurate(uint8_t stored_baudrate)
+{
+    uint32_t requested = baudrate(stored_baudrate);
+    uint32_t real = real_baudrate(stored_baudrate);
+    uint32_t error = real > requested ? real - requested : requested - real;
+    return error * 1000 <= requested * BAUDRATE_TOLERANCE;
 }
 
 #endif // !UTILS_H
@@ -6,6 +6,11 @@
  */
 #define FIRMWARE_VERSION 002 // v0.2
 
+/* Incremented each time the EEPROM layout changes, so that the EEPROM gets
+ * reset to its default content on the first boot of the new firmware
+ */
+#define EEPROM_LAYOUT_VERSION 13
+
 /* Device model number */
 #define MODEL_NB_LW 0xB5
 #define MODEL_NB_HW 0x14
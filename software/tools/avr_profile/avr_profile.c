@@ -0,0 +1,630 @@
+/*
+ * Cycle-accurate profiling of the ToF module firmware under simavr.
+ *
+ * The firmware ELF runs on a simulated ATmega328p at 8 MHz with:
+ *  - the master bus (UART0) fed from a scenario file, the replies being
+ *    logged;
+ *  - two VL53L0X stubs on the I2C bus, powered by their XSHUT pins and
+ *    answering with a fixed range;
+ *  - the sensors' GPIO1 interrupt lines pulsed at each measurement period.
+ *
+ * It reports, for each function of the symbol file (avr-nm output), the
+ * number of calls and the inclusive cycle count, the worst-case latency of
+ * each interrupt vector, and the stack high-water mark.
+ *
+ * Usage: avr_profile -s symbols.txt [options] firmware.elf
+ *   -s FILE   symbol table, from avr-nm --print-size --demangle --defined-only
+ *   -c FILE   scenario file (see scenario.txt)
+ *   -t MS     simulated duration, default 2000 ms
+ *   -r MM     range returned by the sensor stubs, default 500 mm
+ *   -p MS     sensors' measurement period, default 30 ms
+ *   -b BAUD   baudrate of the master bus, default 200000
+ *   -f TEXT   only report the functions whose name contains TEXT (repeatable)
+ *   -n N      number of functions reported, default 30
+ *   -B FILE   cycle budget: lines "<max cycles per call> <function name>",
+ *             exits with status 2 if a budget is exceeded
+ *   -v        print the bytes exchanged on the master bus
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_interrupts.h"
+#include "avr_uart.h"
+#include "avr_twi.h"
+#include "avr_ioport.h"
+
+#define F_CPU 8000000
+#define FLASH_SIZE 0x8000
+#define VECTOR_COUNT 26 // ATmega328p, 4 bytes per vector
+#define RAMEND 0x8FF
+#define MAX_FILTERS 16
+#define MAX_FRAMES 64
+#define MAX_SCENARIO_BYTES 65536
+
+#define MS_TO_CYCLES(ms) ((avr_cycle_count_t)(ms) * (F_CPU / 1000))
+
+/* Pins of the module, see sensor_mgr.h / sensor_mgr.cpp */
+#define MAIN_INT_PIN 2 // PD2, INT0
+#define AUX_INT_PIN 3 // PD3, INT1
+#define MAIN_XSHUT_PIN 4 // PD4
+#define AUX_XSHUT_PIN 5 // PD5
+
+/* VL53L0X registers used by the stub */
+#define VL_DEFAULT_ADDR 0x29
+#define VL_I2C_SLAVE_DEVICE_ADDRESS 0x8A
+#define VL_RESULT_INTERRUPT_STATUS 0x13
+#define VL_RESULT_RANGE_STATUS 0x14
+#define VL_IDENTIFICATION_MODEL_ID 0xC0
+#define VL_RANGE_STATUS_VALID (11 << 3)
+
+
+/* ---------- Symbols and call profile ---------- */
+
+typedef struct
+{
+    uint32_t addr;
+    char *name;
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t max_cycles;
+} symbol_t;
+
+typedef struct
+{
+    int sym;
+    avr_cycle_count_t start;
+    uint16_t sp;
+} frame_t;
+
+static symbol_t *symbols;
+static int symbol_count;
+static int32_t symbol_at[FLASH_SIZE / 2]; // function starting at each word address
+static frame_t frames[MAX_FRAMES];
+static int frame_count;
+static uint64_t frames_lost;
+
+static void load_symbols(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    for (int i = 0; i < FLASH_SIZE / 2; i++) {
+        symbol_at[i] = -1;
+    }
+    char line[1024];
+    int capacity = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned addr, size;
+        char type;
+        int name_pos;
+        if (sscanf(line, "%x %x %c %n", &addr, &size, &type, &name_pos) != 3) {
+            continue;
+        }
+        if (type != 't' && type != 'T' && type != 'W') {
+            continue;
+        }
+        if (addr >= FLASH_SIZE || symbol_at[addr / 2] >= 0) {
+            continue;
+        }
+        line[strcspn(line, "\n")] = '\0';
+        if (symbol_count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            symbols = realloc(symbols, capacity * sizeof(symbol_t));
+        }
+        symbol_t *s = &symbols[symbol_count];
+        memset(s, 0, sizeof(symbol_t));
+        s->addr = addr;
+        s->name = strdup(line + name_pos);
+        symbol_at[addr / 2] = symbol_count;
+        symbol_count++;
+    }
+    fclose(f);
+}
+
+static void leave_frames(uint16_t sp, avr_cycle_count_t now)
+{
+    /* After the RET, the stack pointer is above its value at the entry */
+    while (frame_count > 0 && sp > frames[frame_count - 1].sp) {
+        frame_t *fr = &frames[--frame_count];
+        symbol_t *s = &symbols[fr->sym];
+        uint64_t cycles = now - fr->start;
+        s->calls++;
+        s->cycles += cycles;
+        if (cycles > s->max_cycles) {
+            s->max_cycles = cycles;
+        }
+    }
+}
+
+static void enter_frame(int sym, uint16_t sp, avr_cycle_count_t now)
+{
+    if (frame_count == MAX_FRAMES) {
+        frames_lost++;
+        return;
+    }
+    frames[frame_count].sym = sym;
+    frames[frame_count].start = now;
+    frames[frame_count].sp = sp;
+    frame_count++;
+}
+
+
+/* ---------- Master bus ---------- */
+
+static uint8_t scenario_bytes[MAX_SCENARIO_BYTES];
+static avr_cycle_count_t scenario_time[MAX_SCENARIO_BYTES];
+static int scenario_length;
+static int scenario_pos;
+static int uart_xoff;
+static int verbose;
+static avr_cycle_count_t next_byte_time;
+static avr_cycle_count_t byte_cycles;
+
+static void add_packet(avr_cycle_count_t t, const uint8_t *params, int count)
+{
+    /* Packet: FF FF ID LEN INSTR PARAMS... CHECKSUM */
+    uint8_t packet[260];
+    int len = 0;
+    uint8_t checksum = 0;
+    packet[len++] = 0xFF;
+    packet[len++] = 0xFF;
+    packet[len++] = params[0];
+    packet[len++] = count + 1;
+    for (int i = 1; i < count + 1 && len < (int)sizeof(packet) - 1; i++) {
+        packet[len++] = params[i];
+    }
+    for (int i = 2; i < len; i++) {
+        checksum += packet[i];
+    }
+    packet[len++] = ~checksum;
+    for (int i = 0; i < len && scenario_length < MAX_SCENARIO_BYTES; i++) {
+        scenario_time[scenario_length] = t;
+        scenario_bytes[scenario_length++] = packet[i];
+    }
+}
+
+/* Scenario lines: "<time ms> <command> <arguments>", commands being
+ *   ping ID / read ID ADDR SIZE / write ID ADDR DATA... / raw BYTES...
+ * Numbers can be decimal or 0x prefixed. */
+static void load_scenario(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    char line[1024];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_number++;
+        line[strcspn(line, "#\n")] = '\0';
+        char *tok = strtok(line, " \t");
+        if (!tok) {
+            continue;
+        }
+        avr_cycle_count_t t = MS_TO_CYCLES(strtoul(tok, NULL, 0));
+        char *cmd = strtok(NULL, " \t");
+        uint8_t args[256];
+        int argc = 0;
+        while ((tok = strtok(NULL, " \t")) && argc < 256) {
+            args[argc++] = strtoul(tok, NULL, 0);
+        }
+        if (!cmd) {
+            fprintf(stderr, "%s:%d: missing command\n", path, line_number);
+            exit(1);
+        }
+        if (strcmp(cmd, "raw") == 0) {
+            for (int i = 0; i < argc && scenario_length < MAX_SCENARIO_BYTES; i++) {
+                scenario_time[scenario_length] = t;
+                scenario_bytes[scenario_length++] = args[i];
+            }
+        }
+        else if (strcmp(cmd, "ping") == 0 && argc == 1) {
+            uint8_t p[] = { args[0], 0x01 };
+            add_packet(t, p, 1);
+        }
+        else if (strcmp(cmd, "read") == 0 && argc == 3) {
+            uint8_t p[] = { args[0], 0x02, args[1], args[2] };
+            add_packet(t, p, 3);
+        }
+        else if (strcmp(cmd, "write") == 0 && argc >= 3) {
+            uint8_t p[258];
+            p[0] = args[0];
+            p[1] = 0x03;
+            memcpy(p + 2, args + 1, argc - 1);
+            add_packet(t, p, argc);
+        }
+        else {
+            fprintf(stderr, "%s:%d: invalid command\n", path, line_number);
+            exit(1);
+        }
+    }
+    fclose(f);
+}
+
+static void uart_output_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    avr_t *avr = param;
+    if (verbose) {
+        printf("[%10.3f ms] << %02X\n", avr->cycle * 1000.0 / F_CPU, value & 0xFF);
+    }
+}
+
+static void uart_xon_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    uart_xoff = 0;
+}
+
+static void uart_xoff_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    uart_xoff = 1;
+}
+
+static void feed_uart(avr_t *avr, avr_irq_t *input)
+{
+    if (scenario_pos >= scenario_length || uart_xoff ||
+            avr->cycle < next_byte_time || avr->cycle < scenario_time[scenario_pos]) {
+        return;
+    }
+    uint8_t byte = scenario_bytes[scenario_pos++];
+    if (verbose) {
+        printf("[%10.3f ms] >> %02X\n", avr->cycle * 1000.0 / F_CPU, byte);
+    }
+    avr_raise_irq(input, byte);
+    next_byte_time = avr->cycle + byte_cycles;
+}
+
+
+/* ---------- VL53L0X stubs ---------- */
+
+typedef struct
+{
+    uint8_t address; // 7 bits
+    int powered;
+    uint8_t regs[256];
+} vl53l0x_t;
+
+typedef struct
+{
+    avr_irq_t *irq;
+    vl53l0x_t sensors[2];
+    vl53l0x_t *selected;
+    int index_written;
+    uint8_t index;
+    uint16_t range;
+} i2c_bus_t;
+
+static void vl53l0x_reset(vl53l0x_t *s)
+{
+    memset(s->regs, 0, sizeof(s->regs));
+    s->address = VL_DEFAULT_ADDR;
+    s->regs[VL_IDENTIFICATION_MODEL_ID] = 0xEE;
+}
+
+static uint8_t vl53l0x_read(i2c_bus_t *bus, vl53l0x_t *s, uint8_t index)
+{
+    switch (index) {
+    case VL_RESULT_INTERRUPT_STATUS:
+        return 0x07; // measurement always ready
+    case VL_RESULT_RANGE_STATUS:
+        return VL_RANGE_STATUS_VALID;
+    case VL_RESULT_RANGE_STATUS + 10:
+        return bus->range >> 8;
+    case VL_RESULT_RANGE_STATUS + 11:
+        return bus->range & 0xFF;
+    case 0x83:
+        return s->regs[index] | 0x01; // SPAD info ready
+    default:
+        return s->regs[index];
+    }
+}
+
+static void i2c_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    i2c_bus_t *bus = param;
+    avr_twi_msg_irq_t v;
+    v.u.v = value;
+
+    if (v.u.twi.msg & TWI_COND_STOP) {
+        bus->selected = NULL;
+    }
+    if (v.u.twi.msg & TWI_COND_START) {
+        bus->selected = NULL;
+        bus->index_written = 0;
+        for (int i = 0; i < 2; i++) {
+            vl53l0x_t *s = &bus->sensors[i];
+            if (s->powered && s->address == (v.u.twi.addr >> 1)) {
+                bus->selected = s;
+                avr_raise_irq(bus->irq + TWI_IRQ_INPUT,
+                    avr_twi_irq_msg(TWI_COND_ACK, v.u.twi.addr, 1));
+                break;
+            }
+        }
+    }
+    vl53l0x_t *s = bus->selected;
+    if (!s) {
+        return;
+    }
+    if (v.u.twi.msg & TWI_COND_WRITE) {
+        avr_raise_irq(bus->irq + TWI_IRQ_INPUT,
+            avr_twi_irq_msg(TWI_COND_ACK, v.u.twi.addr, 1));
+        if (!bus->index_written) {
+            bus->index = v.u.twi.data;
+            bus->index_written = 1;
+        }
+        else {
+            s->regs[bus->index] = v.u.twi.data;
+            if (bus->index == VL_I2C_SLAVE_DEVICE_ADDRESS) {
+                s->address = v.u.twi.data & 0x7F;
+            }
+            bus->index++;
+        }
+    }
+    if (v.u.twi.msg & TWI_COND_READ) {
+        uint8_t data = vl53l0x_read(bus, s, bus->index++);
+        avr_raise_irq(bus->irq + TWI_IRQ_INPUT,
+            avr_twi_irq_msg(TWI_COND_READ, v.u.twi.addr, data));
+    }
+}
+
+static void xshut_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    vl53l0x_t *s = param;
+    if (value && !s->powered) {
+        vl53l0x_reset(s);
+    }
+    s->powered = value != 0;
+}
+
+
+/* ---------- Report ---------- */
+
+static int compare_cycles(const void *a, const void *b)
+{
+    const symbol_t *sa = a;
+    const symbol_t *sb = b;
+    return sa->cycles < sb->cycles ? 1 : sa->cycles > sb->cycles ? -1 : 0;
+}
+
+static int check_budget(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    int exceeded = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "#\n")] = '\0';
+        unsigned long budget;
+        int name_pos;
+        if (sscanf(line, "%lu %n", &budget, &name_pos) != 1 || line[name_pos] == '\0') {
+            continue;
+        }
+        const char *name = line + name_pos;
+        int found = 0;
+        for (int i = 0; i < symbol_count; i++) {
+            if (strcmp(symbols[i].name, name) == 0) {
+                found = 1;
+                if (symbols[i].max_cycles > budget) {
+                    printf("BUDGET EXCEEDED: %s: %llu > %lu cycles\n", name,
+                        (unsigned long long)symbols[i].max_cycles, budget);
+                    exceeded = 1;
+                }
+            }
+        }
+        if (!found) {
+            printf("budget: unknown function %s\n", name);
+        }
+    }
+    fclose(f);
+    return exceeded;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *symbol_path = NULL;
+    const char *scenario_path = NULL;
+    const char *budget_path = NULL;
+    const char *filters[MAX_FILTERS];
+    int filter_count = 0;
+    unsigned duration_ms = 2000;
+    unsigned range = 500;
+    unsigned period_ms = 30;
+    unsigned long baudrate = 200000;
+    int report_count = 30;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:c:t:r:p:b:f:n:B:v")) != -1) {
+        switch (opt) {
+        case 's': symbol_path = optarg; break;
+        case 'c': scenario_path = optarg; break;
+        case 't': duration_ms = strtoul(optarg, NULL, 0); break;
+        case 'r': range = strtoul(optarg, NULL, 0); break;
+        case 'p': period_ms = strtoul(optarg, NULL, 0); break;
+        case 'b': baudrate = strtoul(optarg, NULL, 0); break;
+        case 'f':
+            if (filter_count < MAX_FILTERS) {
+                filters[filter_count++] = optarg;
+            }
+            break;
+        case 'n': report_count = strtol(optarg, NULL, 0); break;
+        case 'B': budget_path = optarg; break;
+        case 'v': verbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s -s symbols.txt [-c scenario] [-t ms] "
+                "[-r mm] [-p ms] [-b baud] [-f name] [-n count] [-B budget] "
+                "[-v] firmware.elf\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc || !symbol_path) {
+        fprintf(stderr, "missing firmware or symbol file\n");
+        return 1;
+    }
+
+    load_symbols(symbol_path);
+    if (scenario_path) {
+        load_scenario(scenario_path);
+    }
+    byte_cycles = (avr_cycle_count_t)F_CPU * 10 / baudrate;
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(argv[optind], &firmware) != 0) {
+        fprintf(stderr, "cannot read %s\n", argv[optind]);
+        return 1;
+    }
+    avr_t *avr = avr_make_mcu_by_name("atmega328p");
+    if (!avr) {
+        fprintf(stderr, "atmega328p not supported by this simavr\n");
+        return 1;
+    }
+    avr_init(avr);
+    firmware.frequency = F_CPU;
+    avr_load_firmware(avr, &firmware);
+
+    /* Master bus */
+    uint32_t flags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    avr_irq_t *uart_input = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+        uart_output_hook, avr);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUT_XON),
+        uart_xon_hook, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUT_XOFF),
+        uart_xoff_hook, NULL);
+
+    /* Sensors */
+    static const char *twi_names[] = { "vl53l0x.in", "vl53l0x.out" };
+    i2c_bus_t bus;
+    memset(&bus, 0, sizeof(bus));
+    bus.range = range;
+    vl53l0x_reset(&bus.sensors[0]);
+    vl53l0x_reset(&bus.sensors[1]);
+    bus.irq = avr_alloc_irq(&avr->irq_pool, 0, 2, twi_names);
+    avr_irq_register_notify(bus.irq + TWI_IRQ_OUTPUT, i2c_hook, &bus);
+    avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT),
+        bus.irq + TWI_IRQ_OUTPUT);
+    avr_connect_irq(bus.irq + TWI_IRQ_INPUT,
+        avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), MAIN_XSHUT_PIN),
+        xshut_hook, &bus.sensors[0]);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), AUX_XSHUT_PIN),
+        xshut_hook, &bus.sensors[1]);
+    avr_irq_t *main_int = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), MAIN_INT_PIN);
+    avr_irq_t *aux_int = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), AUX_INT_PIN);
+    avr_raise_irq(main_int, 1);
+    avr_raise_irq(aux_int, 1);
+
+    /* Simulation */
+    avr_cycle_count_t end = MS_TO_CYCLES(duration_ms);
+    avr_cycle_count_t period = MS_TO_CYCLES(period_ms);
+    avr_cycle_count_t next_interrupt = period;
+    avr_cycle_count_t pending_since = 0;
+    int pending = 0;
+    uint64_t latency_max[VECTOR_COUNT] = { 0, };
+    uint64_t latency_count[VECTOR_COUNT] = { 0, };
+    uint16_t sp_min = RAMEND;
+    int state = cpu_Running;
+
+    while (avr->cycle < end && state != cpu_Done && state != cpu_Crashed) {
+        feed_uart(avr, uart_input);
+        if (period && avr->cycle >= next_interrupt) {
+            /* Falling edge then release of both GPIO1 lines */
+            avr_raise_irq(main_int, 0);
+            avr_raise_irq(aux_int, 0);
+            avr_raise_irq(main_int, 1);
+            avr_raise_irq(aux_int, 1);
+            next_interrupt += period;
+        }
+
+        state = avr_run(avr);
+
+        avr_cycle_count_t now = avr->cycle;
+        uint16_t sp = avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+        if (sp < sp_min) {
+            sp_min = sp;
+        }
+
+        /* Latency: from the interrupt flag being raised, to the vector */
+        if (avr_has_pending_interrupts(avr)) {
+            if (!pending) {
+                pending = 1;
+                pending_since = now;
+            }
+        }
+        if (avr->pc > 0 && avr->pc < VECTOR_COUNT * 4) {
+            int vector = avr->pc / 4;
+            if (pending) {
+                uint64_t latency = now - pending_since;
+                if (latency > latency_max[vector]) {
+                    latency_max[vector] = latency;
+                }
+                latency_count[vector]++;
+            }
+            pending = 0;
+        }
+
+        leave_frames(sp, now);
+        int32_t sym = avr->pc < FLASH_SIZE ? symbol_at[avr->pc / 2] : -1;
+        if (sym >= 0) {
+            enter_frame(sym, sp, now);
+        }
+    }
+
+    if (state == cpu_Crashed) {
+        printf("CPU CRASHED at pc=0x%04x\n", avr->pc);
+    }
+    printf("Simulated %.1f ms at %d Hz\n\n", avr->cycle * 1000.0 / F_CPU, F_CPU);
+
+    int exceeded = budget_path ? check_budget(budget_path) : 0;
+
+    qsort(symbols, symbol_count, sizeof(symbol_t), compare_cycles);
+    printf("%10s %12s %10s %10s  %s\n", "calls", "cycles", "max/call", "mean/call", "function");
+    int reported = 0;
+    for (int i = 0; i < symbol_count && reported < report_count; i++) {
+        symbol_t *s = &symbols[i];
+        if (s->calls == 0) {
+            continue;
+        }
+        int match = filter_count == 0;
+        for (int j = 0; j < filter_count && !match; j++) {
+            match = strstr(s->name, filters[j]) != NULL;
+        }
+        if (!match) {
+            continue;
+        }
+        printf("%10llu %12llu %10llu %10llu  %s\n", (unsigned long long)s->calls,
+            (unsigned long long)s->cycles, (unsigned long long)s->max_cycles,
+            (unsigned long long)(s->cycles / s->calls), s->name);
+        reported++;
+    }
+    if (frames_lost) {
+        printf("(%llu calls not profiled, call depth above %d)\n",
+            (unsigned long long)frames_lost, MAX_FRAMES);
+    }
+
+    printf("\n%6s %10s %16s\n", "vector", "count", "max latency");
+    for (int i = 1; i < VECTOR_COUNT; i++) {
+        if (latency_count[i]) {
+            printf("%6d %10llu %10llu cycles\n", i,
+                (unsigned long long)latency_count[i], (unsigned long long)latency_max[i]);
+        }
+    }
+
+    printf("\nStack high-water mark: %d bytes (SP min 0x%04x)\n", RAMEND - sp_min, sp_min);
+    return exceeded ? 2 : 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Build the firmware and the simavr harness, then profile the firmware.
+# Extra arguments are passed to avr_profile, e.g.:
+#   ./profile.sh -c scenario.txt -f RegisterStorage -f Sensor::update
+# Fails if the static RAM (.data + .bss) leaves less than RAM_MIN_HEADROOM
+# bytes of the 2 KB of the ATmega328p for the stack.
+# Requires arduino-cli (with the firmware's libraries installed), avr-nm,
+# avr-size, a C compiler and simavr (headers and library).
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+FIRMWARE="$HERE/../../firmware_tof_module"
+BUILD=${BUILD:-"$HERE/build"}
+FQBN=${FQBN:-arduino:avr:pro:cpu=8MHzatmega328}
+RAM_SIZE=2048
+RAM_MIN_HEADROOM=${RAM_MIN_HEADROOM:-512}
+SIMAVR_FLAGS=${SIMAVR_FLAGS:-$(pkg-config --cflags --libs simavr 2>/dev/null || echo "-I/usr/include/simavr -lsimavr -lelf")}
+
+mkdir -p "$BUILD"
+arduino-cli compile --fqbn "$FQBN" --output-dir "$BUILD" "$FIRMWARE"
+ELF="$BUILD/firmware_tof_module.ino.elf"
+avr-nm --print-size --demangle --defined-only "$ELF" > "$BUILD/symbols.txt"
+avr-size -C --mcu=atmega328p "$ELF" || true
+STATIC_RAM=$(avr-size -A "$ELF" | awk '$1 == ".data" || $1 == ".bss" { s += $2 } END { print s }')
+HEADROOM=$((RAM_SIZE - STATIC_RAM))
+echo "Static RAM: $STATIC_RAM bytes, stack headroom: $HEADROOM bytes"
+if [ "$HEADROOM" -lt "$RAM_MIN_HEADROOM" ]; then
+    echo "Stack headroom below $RAM_MIN_HEADROOM bytes" >&2
+    exit 1
+fi
+
+cc -O2 -o "$BUILD/avr_profile" "$HERE/avr_profile.c" $SIMAVR_FLAGS
+"$BUILD/avr_profile" -s "$BUILD/symbols.txt" "$@" "$ELF"
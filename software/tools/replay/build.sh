@@ -0,0 +1,17 @@
+#!/bin/sh
+# Build the replay tool: the firmware sources compiled for the host, with
+# the stubs of the stubs/ directory.
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+FIRMWARE="$HERE/../../firmware_tof_module"
+BUILD=${BUILD:-"$HERE/build"}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -g"}
+
+mkdir -p "$BUILD"
+$CXX $CXXFLAGS -std=c++11 -DSENSOR_CONFIG_API=1 -I"$HERE/stubs" -I"$FIRMWARE" -o "$BUILD/replay" \
+    "$HERE/replay.cpp" \
+    -x c++ "$FIRMWARE/firmware_tof_module.ino" \
+    -x none "$FIRMWARE"/*.cpp
+echo "$BUILD/replay"
@@ -0,0 +1,583 @@
+/*
+ * Replay of a bus capture on the host-built firmware.
+ *
+ * The firmware sources (register storage, sensor manager and the read /
+ * write callbacks of firmware_tof_module.ino) are compiled for the host with
+ * the stubs of the stubs/ directory. The requests of the capture addressed to
+ * the module are given to the firmware callbacks at their recorded time, and
+ * the replies are compared to the recorded ones.
+ *
+ * Usage: replay [options] capture.bin
+ *   -s SPEED    1 for real time, 10 for ten times faster... 0 (default) to
+ *               replay as fast as possible, time being simulated
+ *   -r MM       range seen by the simulated sensors, default 500 mm
+ *   -v MM/S     speed of the simulated obstacle, negative when approaching,
+ *               the range starting at -r, default 0
+ *   -b MS       longest timing budget accepted by the simulated sensors,
+ *               default 255 ms; they always refuse budgets below 20 ms, like
+ *               the VL53L0X
+ *   -e FILE     initial EEPROM image (1024 bytes), default is blank
+ *   -i ADDR:N   ignore N registers from ADDR when comparing (repeatable)
+ *   -m          ignore the measurement registers (ranges, rates, frame...)
+ *   -n N        number of divergences printed, default 20
+ *
+ * The idle sleep of the firmware is simulated: sleep_cpu() returns on the
+ * next interrupt, either a sensor interrupt, a request of the capture (UART
+ * reception) or the tick of the timer 0. Going to sleep while a sensor
+ * measurement or a request is pending is an event missed by the firmware.
+ *
+ * Exit status: 0 if the replies match the capture, 2 if they diverge or if
+ * the firmware missed events.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Wire.h>
+#include <ToF_sensor.h>
+#include <OneWireSInterface.h>
+
+#define CAPTURE_MAGIC "TOFC"
+#define CAPTURE_VERSION 1
+#define RECORD_HEADER_SIZE 10
+#define BROADCAST_ID 0xFE
+
+enum RecordInstruction
+{
+    RECORD_PING = 0x01,
+    RECORD_READ = 0x02,
+    RECORD_WRITE = 0x03,
+    RECORD_FACTORY_RESET = 0x06,
+    RECORD_SOFT_RESET = 0x08
+};
+
+/* Status bits that the replay can reproduce, see ErrCode in the firmware */
+#define STATUS_SENSOR_ERRORS 0x03
+#define STATUS_RANGE_ERROR 0x08
+#define STATUS_NEW_DATA 0x20
+
+/* Continuous measurements take one timing budget */
+#define SENSOR_DEFAULT_BUDGET 33000 // us
+
+/* The first request is replayed once the module had time to start */
+#define BOOT_DELAY 1000000 // us
+
+/* Simulated duration of an iteration of the main loop without request */
+#define LOOP_PERIOD 100 // us
+
+/* Period of the timer 0 overflow interrupt, used by millis(), at 8 MHz */
+#define TIMER0_TICK 1024 // us
+
+void setup();
+void loop();
+
+
+struct Record
+{
+    uint64_t timestamp; // us, micros() wraps being removed
+    uint8_t id;
+    uint8_t instruction;
+    uint8_t address;
+    uint8_t comStatus;
+    uint8_t status;
+    std::vector<uint8_t> data;
+};
+
+struct Divergence
+{
+    size_t record;
+    uint8_t address;
+    int expected;
+    int actual;
+    const char *what;
+};
+
+
+/* ---------- Replay state ---------- */
+
+static std::vector<Record> records;
+static size_t nextRecord;
+static std::vector<Divergence> divergences;
+static std::vector<std::pair<uint8_t, uint8_t> > ignored;
+
+static double speed = 0;
+static uint16_t simRange = 500;
+static int32_t simSpeed = 0; // mm/s
+static uint32_t simMaxBudget = 255000; // us
+static size_t printedDivergences = 20;
+
+static uint64_t clockUs; // simulated time since the start of the module, us
+static std::chrono::steady_clock::time_point realStart;
+
+static uint8_t moduleId = 1;
+static uint8_t hardwareStatus;
+static size_t replayed;
+static size_t skipped;
+static size_t unanswered;
+static double callbackTotalNs;
+static double callbackMaxNs;
+static double maxLatenessUs;
+static size_t sleepCount;
+static uint64_t sleepUs;
+static size_t missedEvents;
+
+static void (*readCallback)(uint8_t, uint8_t, uint8_t *);
+static uint8_t (*writeCallback)(uint8_t, uint8_t, const uint8_t *);
+static void (*softResetCallback)();
+static void (*factoryResetCallback)();
+static void (*interruptHandlers[2])();
+
+
+/* ---------- Clock ---------- */
+
+static uint64_t now()
+{
+    if (speed > 0) {
+        auto elapsed = std::chrono::steady_clock::now() - realStart;
+        double us = std::chrono::duration<double, std::micro>(elapsed).count();
+        clockUs = (uint64_t)(us * speed);
+    }
+    return clockUs;
+}
+
+uint32_t millis() { return now() / 1000; }
+uint32_t micros() { return now(); }
+
+void delay(uint32_t ms)
+{
+    if (speed > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(ms * 1000 / speed)));
+    }
+    else {
+        clockUs += (uint64_t)ms * 1000;
+    }
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if (speed == 0) {
+        clockUs += us;
+    }
+}
+
+
+/* ---------- Arduino stubs ---------- */
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+TwoWire Wire;
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return HIGH; }
+void noInterrupts() {}
+void interrupts() {}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int)
+{
+    if (interrupt < 2) {
+        interruptHandlers[interrupt] = isr;
+    }
+}
+
+size_t Print::print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+size_t Print::print(long n, int) { char b[24]; snprintf(b, sizeof(b), "%ld", n); return print(b); }
+size_t Print::print(unsigned long n, int) { char b[24]; snprintf(b, sizeof(b), "%lu", n); return print(b); }
+size_t Print::println(const char *s) { return print(s) + print("\n"); }
+size_t Print::println(long n, int base) { return print(n, base) + print("\n"); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + print("\n"); }
+
+
+/* ---------- Simulated sensors ---------- */
+
+static ToF_longRange *sensors[2];
+static uint8_t sensorCount;
+
+ToF_longRange::ToF_longRange(uint8_t, uint8_t) :
+    mIndex(sensorCount), mStarted(false), mDataReady(false), mBudget(SENSOR_DEFAULT_BUDGET), mPeriod(0), mNextReady(0),
+    mMinRange(0), mMaxRange(UINT16_MAX)
+{
+    /* The main sensor is constructed first, and uses the interrupt 0 */
+    if (sensorCount < 2) {
+        sensors[sensorCount++] = this;
+    }
+}
+
+int ToF_longRange::powerON(bool) { return EXIT_SUCCESS; }
+void ToF_longRange::standby() { mStarted = false; mDataReady = false; }
+void ToF_longRange::setRange(uint16_t minRange, uint16_t maxRange) { mMinRange = minRange; mMaxRange = maxRange; }
+void ToF_longRange::setQualityThreshold(uint16_t) {}
+
+int ToF_longRange::setTimingBudget(uint32_t budget)
+{
+    if (budget < 20000 || budget > simMaxBudget) {
+        return EXIT_FAILURE;
+    }
+    mBudget = budget;
+    return EXIT_SUCCESS;
+}
+
+int ToF_longRange::setLongRange(bool) { return EXIT_SUCCESS; }
+void ToF_longRange::stopMeasurement() { mStarted = false; mDataReady = false; }
+
+int ToF_longRange::startMeasurement(uint32_t period)
+{
+    mStarted = true;
+    mDataReady = false;
+    mPeriod = max((uint64_t)period * 1000, mBudget);
+    mNextReady = clockUs + mPeriod;
+    return EXIT_SUCCESS;
+}
+
+int ToF_longRange::getFullMeasure(SensorValue &range, uint16_t &rawRange, uint16_t &quality)
+{
+    if (!mDataReady) {
+        return EXIT_FAILURE;
+    }
+    mDataReady = false;
+    int64_t distance = (int64_t)simRange + (int64_t)simSpeed * (int64_t)clockUs / 1000000;
+    rawRange = (uint16_t)constrain(distance, (int64_t)0, (int64_t)UINT16_MAX);
+    quality = 0;
+    if (rawRange < mMinRange) {
+        range = OBSTACLE_TOO_CLOSE;
+    }
+    else if (rawRange > mMaxRange) {
+        range = NO_OBSTACLE;
+    }
+    else {
+        range = rawRange;
+    }
+    return EXIT_SUCCESS;
+}
+
+void ToF_longRange::simulate(uint64_t t)
+{
+    for (uint8_t i = 0; i < sensorCount; i++) {
+        ToF_longRange *s = sensors[i];
+        if (s->mStarted && t >= s->mNextReady) {
+            s->mNextReady += s->mPeriod;
+            s->mDataReady = true;
+            if (interruptHandlers[i]) {
+                interruptHandlers[i]();
+            }
+        }
+    }
+}
+
+uint64_t ToF_longRange::nextEvent()
+{
+    uint64_t next = UINT64_MAX;
+    for (uint8_t i = 0; i < sensorCount; i++) {
+        if (sensors[i]->mStarted && sensors[i]->mNextReady < next) {
+            next = sensors[i]->mNextReady;
+        }
+    }
+    return next;
+}
+
+bool ToF_longRange::eventPending()
+{
+    for (uint8_t i = 0; i < sensorCount; i++) {
+        if (sensors[i]->mDataReady) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* ---------- Idle sleep ---------- */
+
+static uint64_t nextRequestTime()
+{
+    if (nextRecord >= records.size()) {
+        return UINT64_MAX;
+    }
+    return BOOT_DELAY + (records[nextRecord].timestamp - records.front().timestamp);
+}
+
+int HardwareSerial::available()
+{
+    return now() >= nextRequestTime() ? 1 : 0;
+}
+
+void sleep_cpu()
+{
+    uint64_t start = now();
+    if (ToF_longRange::eventPending() || start >= nextRequestTime()) {
+        missedEvents++;
+    }
+    uint64_t wake = (start / TIMER0_TICK + 1) * TIMER0_TICK;
+    wake = min(wake, ToF_longRange::nextEvent());
+    wake = max(min(wake, nextRequestTime()), start);
+    if (speed > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)((wake - start) / speed)));
+    }
+    else {
+        clockUs = wake;
+    }
+    sleepCount++;
+    sleepUs += now() - start;
+    ToF_longRange::simulate(now());
+}
+
+
+/* ---------- Replay ---------- */
+
+static bool isIgnored(uint8_t address)
+{
+    for (size_t i = 0; i < ignored.size(); i++) {
+        if (address >= ignored[i].first && address - ignored[i].first < ignored[i].second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void diverge(uint8_t address, int expected, int actual, const char *what)
+{
+    Divergence d = { nextRecord, address, expected, actual, what };
+    divergences.push_back(d);
+}
+
+static void replayRecord(const Record &r)
+{
+    size_t size = r.data.size();
+    bool answered = r.comStatus == 0;
+    uint8_t reply[256];
+    uint8_t error = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    switch (r.instruction) {
+    case RECORD_READ:
+        if (readCallback) {
+            readCallback(r.address, size, reply);
+        }
+        break;
+    case RECORD_WRITE:
+        if (writeCallback) {
+            error = writeCallback(r.address, size, r.data.data());
+        }
+        break;
+    case RECORD_SOFT_RESET:
+        if (softResetCallback) {
+            softResetCallback();
+        }
+        break;
+    case RECORD_FACTORY_RESET:
+        if (factoryResetCallback) {
+            factoryResetCallback();
+        }
+        break;
+    default:
+        break;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    callbackTotalNs += ns;
+    if (ns > callbackMaxNs) {
+        callbackMaxNs = ns;
+    }
+    replayed++;
+
+    if (!answered || r.id == BROADCAST_ID) {
+        unanswered++;
+        return;
+    }
+    if ((r.status & STATUS_SENSOR_ERRORS) != (hardwareStatus & STATUS_SENSOR_ERRORS)) {
+        diverge(r.address, r.status & STATUS_SENSOR_ERRORS,
+            hardwareStatus & STATUS_SENSOR_ERRORS, "sensor status");
+    }
+    if ((r.status & STATUS_NEW_DATA) != (hardwareStatus & STATUS_NEW_DATA)) {
+        diverge(r.address, r.status & STATUS_NEW_DATA, hardwareStatus & STATUS_NEW_DATA, "new data");
+    }
+    if (r.instruction == RECORD_WRITE && (r.status & STATUS_RANGE_ERROR) != (error & STATUS_RANGE_ERROR)) {
+        diverge(r.address, r.status & STATUS_RANGE_ERROR, error & STATUS_RANGE_ERROR, "write error");
+    }
+    if (r.instruction == RECORD_READ) {
+        for (size_t i = 0; i < size; i++) {
+            uint8_t address = r.address + i;
+            if (reply[i] != r.data[i] && !isIgnored(address)) {
+                diverge(address, r.data[i], reply[i], "register");
+            }
+        }
+    }
+}
+
+static void report()
+{
+    double duration = (records.back().timestamp - records.front().timestamp) / 1e6;
+    printf("Records: %zu replayed, %zu for other modules, %zu without reply in the capture\n",
+        replayed, skipped, unanswered);
+    printf("Capture duration: %.3f s\n", duration);
+    if (replayed > 0) {
+        printf("Callbacks (host): %.0f ns mean, %.0f ns max, %.0f requests/s\n",
+            callbackTotalNs / replayed, callbackMaxNs, replayed * 1e9 / callbackTotalNs);
+    }
+    if (speed > 0) {
+        printf("Max lateness of a request: %.0f us\n", maxLatenessUs);
+    }
+    printf("Idle sleep: %zu sleeps, %.1f %% of the time, %zu events missed\n",
+        sleepCount, now() > 0 ? 100.0 * sleepUs / now() : 0.0, missedEvents);
+    printf("Divergences: %zu\n", divergences.size());
+    for (size_t i = 0; i < divergences.size() && i < printedDivergences; i++) {
+        const Divergence &d = divergences[i];
+        const Record &r = records[d.record];
+        printf("  record %zu (t=%.3f ms, instr 0x%02X @0x%02X): %s 0x%02X expected 0x%02X got 0x%02X\n",
+            d.record, (r.timestamp - records.front().timestamp) / 1e3, r.instruction,
+            r.address, d.what, d.address, d.expected, d.actual);
+    }
+}
+
+/* Called at each iteration of the firmware main loop */
+void OneWireSInterface::communicate()
+{
+    if (nextRecord >= records.size()) {
+        report();
+        exit(divergences.empty() && missedEvents == 0 ? 0 : 2);
+    }
+    const Record &r = records[nextRecord];
+    uint64_t due = nextRequestTime();
+
+    if (speed == 0) {
+        /* Jump to the next event: sensor interrupt, request, or end of the
+         * loop iteration */
+        uint64_t event = min(ToF_longRange::nextEvent(), due);
+        clockUs = max(clockUs, min(event, clockUs + LOOP_PERIOD));
+    }
+    ToF_longRange::simulate(now());
+    if (now() < due) {
+        return;
+    }
+    if (speed > 0 && now() - due > maxLatenessUs) {
+        maxLatenessUs = now() - due;
+    }
+
+    if (r.id == moduleId || r.id == BROADCAST_ID) {
+        replayRecord(r);
+    }
+    else {
+        skipped++;
+    }
+    nextRecord++;
+}
+
+void OneWireSInterface::setReadCallback(void (*callback)(uint8_t, uint8_t, uint8_t *)) { readCallback = callback; }
+void OneWireSInterface::setWriteCallback(uint8_t (*callback)(uint8_t, uint8_t, const uint8_t *)) { writeCallback = callback; }
+void OneWireSInterface::setSoftResetCallback(void (*callback)()) { softResetCallback = callback; }
+void OneWireSInterface::setFactoryResetCallback(void (*callback)()) { factoryResetCallback = callback; }
+void OneWireSInterface::setID(uint8_t id) { moduleId = id; }
+void OneWireSInterface::setHardwareStatus(uint8_t status) { hardwareStatus = status; }
+
+
+static void loadCapture(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    char magic[4];
+    int version = 0;
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, CAPTURE_MAGIC, 4) != 0 ||
+            (version = fgetc(f)) != CAPTURE_VERSION) {
+        fprintf(stderr, "%s: not a capture, or unsupported version %d\n", path, version);
+        exit(1);
+    }
+    uint8_t header[RECORD_HEADER_SIZE];
+    uint64_t wraps = 0;
+    uint32_t last = 0;
+    while (fread(header, 1, RECORD_HEADER_SIZE, f) == RECORD_HEADER_SIZE) {
+        Record r;
+        uint32_t t = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+        /* micros() wraps every 71 minutes */
+        if (!records.empty() && t < last) {
+            wraps += (uint64_t)1 << 32;
+        }
+        last = t;
+        r.timestamp = t + wraps;
+        r.id = header[4];
+        r.instruction = header[5];
+        r.address = header[6];
+        r.comStatus = header[8];
+        r.status = header[9];
+        r.data.resize(header[7]);
+        if (fread(r.data.data(), 1, r.data.size(), f) != r.data.size()) {
+            fprintf(stderr, "%s: truncated record %zu\n", path, records.size());
+            break;
+        }
+        records.push_back(r);
+    }
+    fclose(f);
+    if (records.empty()) {
+        fprintf(stderr, "%s: empty capture\n", path);
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *eepromPath = nullptr;
+    int opt;
+    memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+
+    while ((opt = getopt(argc, argv, "s:r:v:b:e:i:mn:")) != -1) {
+        switch (opt) {
+        case 's': speed = atof(optarg); break;
+        case 'r': simRange = strtoul(optarg, nullptr, 0); break;
+        case 'v': simSpeed = strtol(optarg, nullptr, 0); break;
+        case 'b': simMaxBudget = strtoul(optarg, nullptr, 0) * 1000; break;
+        case 'e': eepromPath = optarg; break;
+        case 'i': {
+            unsigned address, count;
+            if (sscanf(optarg, "%i:%i", &address, &count) == 2) {
+                ignored.push_back(std::make_pair(address, count));
+            }
+            break;
+        }
+        case 'm':
+            /* See RegisterMap in register_storage.h */
+            ignored.push_back(std::make_pair(0x23, 14)); // MCSLR, ranges, raw ranges, qualities
+            ignored.push_back(std::make_pair(0x31, 1)); // input voltage
+            ignored.push_back(std::make_pair(0x3D, 8)); // current periods, range rates
+            ignored.push_back(std::make_pair(0x4A, 6)); // merged stream
+            ignored.push_back(std::make_pair(0x53, 17)); // trace
+            ignored.push_back(std::make_pair(0x6A, 32)); // page window
+            ignored.push_back(std::make_pair(0x92, 12)); // frame, real baudrate
+            ignored.push_back(std::make_pair(0xA8, 8)); // idle sleep counters
+            ignored.push_back(std::make_pair(0xD4, 4)); // measurement rates
+            ignored.push_back(std::make_pair(0xE8, 4)); // times to contact
+            break;
+        case 'n': printedDivergences = strtoul(optarg, nullptr, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-s speed] [-r mm] [-e eeprom.bin] "
+                "[-i addr:size] [-m] [-n count] capture.bin\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "missing capture file\n");
+        return 1;
+    }
+    loadCapture(argv[optind]);
+    if (eepromPath) {
+        FILE *f = fopen(eepromPath, "rb");
+        if (!f || fread(EEPROM.data, 1, sizeof(EEPROM.data), f) != sizeof(EEPROM.data)) {
+            fprintf(stderr, "%s: cannot read the EEPROM image\n", eepromPath);
+            return 1;
+        }
+        fclose(f);
+    }
+
+    clockUs = 0;
+    realStart = std::chrono::steady_clock::now();
+
+    setup();
+    while (true) {
+        loop();
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <Arduino.h>
+
+struct EEPROMClass
+{
+    uint8_t data[E2END + 1];
+
+    uint8_t read(int address) { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; }
+    void update(int address, uint8_t value) { data[address] = value; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,34 @@
+/* Slave interface for the host build of the firmware: the requests are
+ * taken from the capture being replayed, see replay.cpp */
+#ifndef ONE_WIRE_S_INTERFACE_H
+#define ONE_WIRE_S_INTERFACE_H
+
+#include <Arduino.h>
+
+class OneWireInterface
+{
+public:
+    static const uint8_t NO_DIR_PORT = 255;
+};
+
+class OneWireSInterface : public OneWireInterface
+{
+public:
+    OneWireSInterface(HardwareSerial &, uint8_t, uint8_t, uint8_t, Stream * = nullptr) {}
+
+    void setReadCallback(void (*callback)(uint8_t, uint8_t, uint8_t *));
+    void setWriteCallback(uint8_t (*callback)(uint8_t, uint8_t, const uint8_t *));
+    void setSoftResetCallback(void (*callback)());
+    void setFactoryResetCallback(void (*callback)());
+
+    void begin(uint32_t) {}
+    void end() {}
+    void setID(uint8_t id);
+    void setRDT(uint32_t) {}
+    void setSRL(uint8_t) {}
+    void setHardwareStatus(uint8_t status);
+    void communicate();
+    bool waitingToSendPacket() const { return false; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef SOFTWARE_SERIAL_H
+#define SOFTWARE_SERIAL_H
+
+#include <Arduino.h>
+
+class SoftwareSerial : public Stream
+{
+public:
+    SoftwareSerial(uint8_t, uint8_t) {}
+    void begin(long) {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+#endif
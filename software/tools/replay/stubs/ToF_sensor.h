@@ -0,0 +1,53 @@
+/* Simulated VL53L0X for the host build of the firmware, implemented in
+ * replay.cpp: every sensor sees an obstacle at the same, fixed distance, and
+ * signals a new measurement on its interrupt line once per period. */
+#ifndef TOF_SENSOR_H
+#define TOF_SENSOR_H
+
+#include <Arduino.h>
+
+typedef int32_t SensorValue;
+enum SensorValueEnum
+{
+    SENSOR_DEAD = 0,
+    SENSOR_NOT_UPDATED = 1,
+    OBSTACLE_TOO_CLOSE = 2,
+    NO_OBSTACLE = 3
+};
+
+class ToF_longRange
+{
+public:
+    ToF_longRange(uint8_t address, uint8_t resetPin);
+
+    int powerON(bool);
+    void standby();
+    void setRange(uint16_t minRange, uint16_t maxRange);
+    void setQualityThreshold(uint16_t threshold);
+    int setTimingBudget(uint32_t budget); // us
+    int setLongRange(bool longRange);
+    int startMeasurement(uint32_t period);
+    void stopMeasurement();
+    bool measurementStarted() const { return mStarted; }
+    int getFullMeasure(SensorValue &range, uint16_t &rawRange, uint16_t &quality);
+
+    /* Simulation: raise the interrupt of the sensors due at the given time */
+    static void simulate(uint64_t now);
+    static uint64_t nextEvent();
+
+    /* Simulation: true if an interrupt was raised and the measurement was
+     * not read yet */
+    static bool eventPending();
+
+private:
+    uint8_t mIndex;
+    bool mStarted;
+    bool mDataReady;
+    uint64_t mBudget; // us
+    uint64_t mPeriod; // us
+    uint64_t mNextReady; // us
+    uint16_t mMinRange;
+    uint16_t mMaxRange;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+struct TwoWire
+{
+    void begin() {}
+    void setClock(unsigned long) {}
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,13 @@
+/* Idle sleep for the host build of the firmware: sleep_cpu() is implemented
+ * in replay.cpp and waits for the next simulated interrupt */
+#ifndef AVR_SLEEP_H
+#define AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(int) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+void sleep_cpu();
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef UTIL_ATOMIC_H
+#define UTIL_ATOMIC_H
+
+/* The host build has no interrupts running concurrently */
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) for (int _atomic_once = 1; _atomic_once; _atomic_once = 0)
+
+#endif
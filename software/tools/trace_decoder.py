@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Decode the binary trace of the ToF module firmware into a timeline.
+
+The trace records are 4 bytes long: event id, argument, and a 16 bits time
+stamp (little endian) in units of 16 us, which wraps every 1.05 s.
+
+Two input formats are supported:
+  - raw: records concatenated, as read from the REG_TRACE_DATA window
+    (records with a null event id are padding and are skipped)
+  - framed: each record preceded by the 0xA5 sync byte, as sent on the
+    debug serial by the firmware built with DEBUG_TRACE set
+
+Input may be a binary file, or a text file of hexadecimal bytes (--hex).
+"""
+
+import argparse
+import sys
+
+TIME_UNIT_US = 16
+TIME_WRAP = 1 << 16
+SYNC_BYTE = 0xA5
+RECORD_SIZE = 4
+
+# Keep in sync with firmware_tof_module/trace.h
+EVENTS = {
+    1: ("OVERFLOW", "lost={}"),
+    2: ("START", "warm={}"),
+    3: ("SOFT_RESET", None),
+    4: ("FACTORY_RESET", None),
+    5: ("READ", "addr=0x{:02X}"),
+    6: ("WRITE", "addr=0x{:02X}"),
+    7: ("SENSOR_READY", "sensor={}"),
+    8: ("MEASURE", "sensor={}"),
+    9: ("SENSOR_FAULT", "sensor={}"),
+    10: ("POWER_ON", None),
+    11: ("VCC", "voltage={:.2f}V"),
+    12: ("BAUDRATE", "register={}"),
+    13: ("CONFIG_REJECTED", "sensor={}"),
+}
+
+
+def format_arg(event, arg):
+    if event == 10:
+        return "sensor={} {}".format(arg & 0x7F, "ok" if arg & 0x80 else "failed")
+    if event == 11:
+        return EVENTS[event][1].format(arg * 0.04)
+    name, fmt = EVENTS.get(event, (None, "arg={}"))
+    return fmt.format(arg) if fmt else ""
+
+
+def raw_records(data):
+    for i in range(0, len(data) - RECORD_SIZE + 1, RECORD_SIZE):
+        record = data[i:i + RECORD_SIZE]
+        if record[0] != 0:
+            yield record
+
+
+def framed_records(data):
+    i = 0
+    while i + RECORD_SIZE < len(data):
+        if data[i] == SYNC_BYTE and 0 < data[i + 1] <= max(EVENTS):
+            yield data[i + 1:i + 1 + RECORD_SIZE]
+            i += RECORD_SIZE + 1
+        else:
+            i += 1
+
+
+def timeline(records):
+    """Unwrap the time stamps, assuming consecutive records are less than
+    1.05 s apart"""
+    time = None
+    last = 0
+    for record in records:
+        stamp = record[2] | (record[3] << 8)
+        if time is None:
+            time = 0
+        else:
+            time += (stamp - last) % TIME_WRAP
+        last = stamp
+        yield time * TIME_UNIT_US, record[0], record[1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="trace file, '-' for stdin")
+    parser.add_argument("--framed", action="store_true",
+        help="records are preceded by a sync byte (debug serial output)")
+    parser.add_argument("--hex", action="store_true",
+        help="input is a text file of hexadecimal bytes")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    if args.hex:
+        data = bytes(int(b, 16) for b in data.decode().split())
+
+    records = framed_records(data) if args.framed else raw_records(data)
+    previous = 0
+    for time_us, event, arg in timeline(records):
+        name = EVENTS.get(event, ("EVENT_{}".format(event), None))[0]
+        print("{:12.6f}  +{:9.6f}  {:<14} {}".format(time_us / 1e6,
+            (time_us - previous) / 1e6, name, format_arg(event, arg)))
+        previous = time_us
+
+
+if __name__ == "__main__":
+    main()